@@ -0,0 +1,364 @@
+#include "LoadGenerator.class.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+LoadGenerator::LoadGenerator(const Options &options)
+	: _options(options), _members(options.channels, 0), _registered(0), _joined(0), _sent(0),
+	  _delivered(0), _errors(0)
+{
+}
+
+
+LoadGenerator::~LoadGenerator()
+{
+	for (size_t i = 0; i < _connections.size(); ++i)
+	{
+		close(_connections[i]->fd);
+		delete _connections[i];
+	}
+}
+
+
+uint64_t LoadGenerator::nowUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+bool LoadGenerator::run()
+{
+	if (!_loop.init())
+	{
+		std::cerr << "Error creating the event loop: " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	// Registration: every connection sends PASS/NICK/USER as soon as it is opened
+	uint64_t start = nowUs();
+	if (!connectAll() || !waitFor(_registered, _options.clients, "registration"))
+		return false;
+	report("registrations", _registered, nowUs() - start);
+
+	// Topology: connection i joins channelsPerClient consecutive channels
+	size_t expectedJoins = 0;
+	start = nowUs();
+	for (size_t i = 0; i < _connections.size(); ++i)
+	{
+		Connection &connection = *_connections[i];
+		for (size_t k = 0; k < _options.channelsPerClient; ++k)
+		{
+			size_t channel = (i * _options.channelsPerClient + k) % _options.channels;
+			connection.channels.push_back(channel);
+			_members[channel]++;
+			std::ostringstream line;
+			line << "JOIN #bench" << channel << "\r\n";
+			send(connection, line.str());
+			expectedJoins++;
+		}
+	}
+	if (!waitFor(_joined, expectedJoins, "join"))
+		return false;
+	report("joins", _joined, nowUs() - start);
+
+	// Traffic: every message reaches the other members of its channel
+	size_t expected = 0;
+	for (size_t i = 0; i < _connections.size(); ++i)
+	{
+		const std::vector<size_t> &channels = _connections[i]->channels;
+		for (size_t m = 0; m < _options.messages; ++m)
+			expected += _members[channels[m % channels.size()]] - 1;
+	}
+	_latenciesUs.reserve(expected);
+
+	start = nowUs();
+	uint64_t lastProgress = start;
+	size_t total = _options.clients * _options.messages;
+	while (_sent < total || _delivered < expected)
+	{
+		size_t before = _sent + _delivered;
+		if (_sent < total)
+			refillTraffic(start);
+		if (!pump(_sent < total ? 1 : 100))
+			return false;
+		if (_sent + _delivered != before)
+			lastProgress = nowUs();
+		else if (nowUs() - lastProgress > static_cast<uint64_t>(_options.timeoutSec) * 1000000)
+		{
+			std::cerr << "traffic stalled: " << _delivered << " of " << expected << " deliveries" << std::endl;
+			break;
+		}
+	}
+	uint64_t elapsed = nowUs() - start;
+	report("messages sent", _sent, elapsed);
+	report("messages delivered", _delivered, elapsed);
+	if (_errors)
+		std::cout << "server errors:        " << _errors << std::endl;
+	reportLatency();
+	return _delivered == expected;
+}
+
+
+bool LoadGenerator::connectAll()
+{
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(_options.port);
+	if (inet_pton(AF_INET, _options.host.c_str(), &addr.sin_addr) != 1)
+	{
+		std::cerr << "Invalid address: " << _options.host << std::endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < _options.clients; ++i)
+	{
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0 || fcntl(fd, F_SETFL, O_NONBLOCK) == -1)
+		{
+			std::cerr << "Error creating socket " << i << ": " << strerror(errno) << std::endl;
+			if (fd >= 0)
+				close(fd);
+			return false;
+		}
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 && errno != EINPROGRESS)
+		{
+			std::cerr << "Error connecting socket " << i << ": " << strerror(errno) << std::endl;
+			close(fd);
+			return false;
+		}
+
+		Connection *connection = new Connection();
+		connection->fd = fd;
+		connection->outputOffset = 0;
+		connection->wantsWrite = false;
+		connection->registered = false;
+		connection->joined = 0;
+		connection->sent = 0;
+		_connections.push_back(connection);
+		if (static_cast<size_t>(fd) >= _byFd.size())
+			_byFd.resize(fd + 1, NULL);
+		_byFd[fd] = connection;
+		_loop.add(fd, EventLoop::READ);
+
+		char nick[16];
+		snprintf(nick, sizeof(nick), "b%05lu", static_cast<unsigned long>(i));
+		send(*connection, "PASS " + _options.password + "\r\n"
+			+ "NICK " + nick + "\r\n"
+			+ "USER " + nick + " 0 * :bench client\r\n");
+
+		// Keep the handshakes flowing while the rest is being opened
+		if (i % 64 == 63 && !pump(0))
+			return false;
+	}
+	return true;
+}
+
+
+bool LoadGenerator::waitFor(const size_t &counter, size_t target, const char *phase)
+{
+	uint64_t lastProgress = nowUs();
+	size_t last = counter;
+	while (counter < target)
+	{
+		if (!pump(100))
+			return false;
+		if (counter != last)
+		{
+			last = counter;
+			lastProgress = nowUs();
+		}
+		else if (nowUs() - lastProgress > static_cast<uint64_t>(_options.timeoutSec) * 1000000)
+		{
+			std::cerr << phase << " stalled: " << counter << " of " << target << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool LoadGenerator::pump(int timeoutMs)
+{
+	std::vector<EventLoop::Event> events;
+	if (_loop.wait(events, timeoutMs) == -1)
+	{
+		std::cerr << "Event loop failed: " << strerror(errno) << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		Connection *connection = _byFd[events[i].fd];
+		if (events[i].events & (EventLoop::HANGUP | EventLoop::ERROR))
+		{
+			std::cerr << "Connection " << events[i].fd << " closed by the server" << std::endl;
+			return false;
+		}
+		if (events[i].events & EventLoop::WRITE)
+			writeTo(*connection);
+		if (events[i].events & EventLoop::READ)
+			readFrom(*connection);
+	}
+	return true;
+}
+
+
+void LoadGenerator::readFrom(Connection &connection)
+{
+	while (true)
+	{
+		connection.input.compact();
+		ssize_t bytes = recv(connection.fd, connection.input.writePtr(), connection.input.writable(), 0);
+		if (bytes <= 0)
+			break;
+		connection.input.commit(bytes);
+
+		const char *line;
+		size_t length;
+		while (connection.input.nextLine(line, length))
+			handleLine(connection, line, length);
+	}
+}
+
+
+void LoadGenerator::writeTo(Connection &connection)
+{
+	while (connection.outputOffset < connection.output.size())
+	{
+		ssize_t written = ::send(connection.fd, connection.output.data() + connection.outputOffset,
+			connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+		if (written <= 0)
+			break;
+		connection.outputOffset += written;
+	}
+	if (connection.outputOffset == connection.output.size())
+	{
+		connection.output.clear();
+		connection.outputOffset = 0;
+	}
+
+	bool pending = !connection.output.empty();
+	if (pending != connection.wantsWrite)
+	{
+		_loop.modify(connection.fd, pending ? (EventLoop::READ | EventLoop::WRITE) : EventLoop::READ);
+		connection.wantsWrite = pending;
+	}
+}
+
+
+void LoadGenerator::send(Connection &connection, const std::string &line)
+{
+	connection.output += line;
+	if (!connection.wantsWrite)
+		writeTo(connection);
+}
+
+
+void LoadGenerator::handleLine(Connection &connection, const char *line, size_t length)
+{
+	std::string text(line, length);
+
+	if (text.compare(0, 5, "PING ") == 0)
+	{
+		send(connection, "PONG " + text.substr(5) + "\r\n");
+		return;
+	}
+	if (text.compare(0, 6, "ERROR ") == 0)
+	{
+		_errors++;
+		return;
+	}
+
+	std::string::size_type space = text.find(' ');
+	if (space == std::string::npos)
+		return;
+	std::string command = text.substr(space + 1, 4);
+	if (command == "001 " && !connection.registered)
+	{
+		connection.registered = true;
+		_registered++;
+	}
+	else if (command == "366 ")
+	{
+		connection.joined++;
+		_joined++;
+	}
+	else if (command == "PRIV")
+	{
+		// :nick!user@host PRIVMSG #chan :bench <timestamp> <seq>
+		std::string::size_type body = text.find(" :bench ");
+		if (body == std::string::npos)
+			return;
+		uint64_t sentAt = strtoull(text.c_str() + body + 8, NULL, 10);
+		uint64_t now = nowUs();
+		_latenciesUs.push_back(now > sentAt ? static_cast<uint32_t>(now - sentAt) : 0);
+		_delivered++;
+	}
+	else if (text.size() > space + 1 && text[space + 1] >= '4' && text[space + 1] <= '5')
+		_errors++;	// 4xx/5xx numeric replies
+}
+
+
+// Queues the next messages, one per connection per pass, within the rate
+size_t LoadGenerator::refillTraffic(uint64_t startUs)
+{
+	size_t total = _options.clients * _options.messages;
+	size_t budget = total - _sent;
+	if (_options.rate)
+	{
+		uint64_t allowed = (nowUs() - startUs) * _options.rate / 1000000 + 1;
+		budget = (allowed > _sent) ? std::min<uint64_t>(allowed - _sent, budget) : 0;
+	}
+
+	size_t queued = 0;
+	for (size_t i = 0; i < _connections.size() && queued < budget; ++i)
+	{
+		Connection &connection = *_connections[i];
+		if (connection.sent >= _options.messages || connection.output.size() > 4096)
+			continue;
+		std::ostringstream line;
+		line << "PRIVMSG #bench" << connection.channels[connection.sent % connection.channels.size()]
+			<< " :bench " << nowUs() << " " << connection.sent << "\r\n";
+		send(connection, line.str());
+		connection.sent++;
+		_sent++;
+		queued++;
+	}
+	return queued;
+}
+
+
+void LoadGenerator::report(const char *phase, size_t count, uint64_t elapsedUs) const
+{
+	double seconds = elapsedUs / 1e6;
+	std::cout.setf(std::ios::fixed);
+	std::cout.precision(3);
+	std::cout << phase << ": " << count << " in " << seconds << " s";
+	std::cout.precision(0);
+	std::cout << " (" << (seconds > 0 ? count / seconds : 0) << "/s)" << std::endl;
+}
+
+
+void LoadGenerator::reportLatency()
+{
+	if (_latenciesUs.empty())
+		return;
+	std::sort(_latenciesUs.begin(), _latenciesUs.end());
+	size_t n = _latenciesUs.size();
+	std::cout << "delivery latency (us): p50 " << _latenciesUs[n * 50 / 100]
+		<< "  p99 " << _latenciesUs[n * 99 / 100]
+		<< "  p999 " << _latenciesUs[n * 999 / 1000]
+		<< "  max " << _latenciesUs[n - 1] << std::endl;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "EventLoop.class.hpp"
+#include "LineBuffer.class.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * End-to-end load generator for ircserv.
+ * Opens many loopback connections, registers them (PASS/NICK/USER), joins
+ * them to a configurable channel topology and drives PRIVMSG traffic whose
+ * bodies carry the send timestamp, so that every delivery gives a latency.
+ */
+class LoadGenerator
+{
+  public:
+	struct Options
+	{
+		std::string host;
+		int port;
+		std::string password;
+		size_t clients;				// connections to open
+		size_t channels;			// channels in the topology
+		size_t channelsPerClient;	// channels joined by each connection
+		size_t messages;			// PRIVMSG sent by each connection
+		size_t rate;				// messages/s for all connections, 0 = unthrottled
+		int timeoutSec;				// give up after this long without progress
+	};
+
+	explicit LoadGenerator(const Options &options);
+	~LoadGenerator();
+
+	// Runs every phase and prints the report, false if a phase failed
+	bool run();
+
+  private:
+	struct Connection
+	{
+		int fd;
+		LineBuffer input;
+		std::string output;
+		size_t outputOffset;
+		bool wantsWrite;
+		bool registered;
+		size_t joined;
+		size_t sent;
+		std::vector<size_t> channels;
+	};
+
+	Options _options;
+	EventLoop _loop;
+	std::vector<Connection *> _connections;
+	std::vector<Connection *> _byFd;
+	std::vector<size_t> _members;	// connections per channel
+
+	size_t _registered;
+	size_t _joined;
+	size_t _sent;
+	size_t _delivered;
+	size_t _errors;
+	std::vector<uint32_t> _latenciesUs;
+
+	bool connectAll();
+	bool waitFor(const size_t &counter, size_t target, const char *phase);
+	bool pump(int timeoutMs);
+	void readFrom(Connection &connection);
+	void writeTo(Connection &connection);
+	void send(Connection &connection, const std::string &line);
+	void handleLine(Connection &connection, const char *line, size_t length);
+	size_t refillTraffic(uint64_t startUs);
+	void report(const char *phase, size_t count, uint64_t elapsedUs) const;
+	void reportLatency();
+
+	static uint64_t nowUs();
+
+	LoadGenerator(const LoadGenerator &);
+	LoadGenerator &operator=(const LoadGenerator &);
+};
@@ -0,0 +1,71 @@
+#include "LoadGenerator.class.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static void usage()
+{
+	std::cerr << "Usage: ./ircbench <host> <port> <password> [-c clients] [-C channels]"
+		" [-j channels per client] [-m messages per client] [-r messages/s] [-t timeout s]" << std::endl;
+}
+
+
+int main(int ac, char **av)
+{
+	if (ac < 4)
+	{
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	LoadGenerator::Options options;
+	options.host = av[1];
+	options.port = std::atoi(av[2]);
+	options.password = av[3];
+	options.clients = 500;
+	options.channels = 10;
+	options.channelsPerClient = 1;
+	options.messages = 20;
+	options.rate = 0;
+	options.timeoutSec = 10;
+
+	int opt;
+	optind = 4;
+	while ((opt = getopt(ac, av, "c:C:j:m:r:t:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'c': options.clients = std::strtoul(optarg, NULL, 10); break;
+			case 'C': options.channels = std::strtoul(optarg, NULL, 10); break;
+			case 'j': options.channelsPerClient = std::strtoul(optarg, NULL, 10); break;
+			case 'm': options.messages = std::strtoul(optarg, NULL, 10); break;
+			case 'r': options.rate = std::strtoul(optarg, NULL, 10); break;
+			case 't': options.timeoutSec = std::atoi(optarg); break;
+			default: usage(); return EXIT_FAILURE;
+		}
+	}
+	if (options.port <= 0 || options.clients == 0 || options.clients > 99999 || options.channels == 0
+		|| options.channelsPerClient == 0 || options.channelsPerClient > options.channels)
+	{
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	// Thousands of connections need more descriptors than the usual soft limit
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	std::cout << "ircbench: " << options.clients << " clients, " << options.channels << " channels, "
+		<< options.channelsPerClient << " joined each, " << options.messages << " messages each"
+		<< (options.rate ? "" : ", unthrottled") << std::endl;
+
+	LoadGenerator generator(options);
+	return generator.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,226 @@
+#include "Channel.class.hpp"
+#include "Client.class.hpp"
+#include "IrcFormatter.class.hpp"
+#include "IrcMessage.class.hpp"
+#include "Logger.class.hpp"
+#include "Server.class.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Per-call cost of the pieces on the hot path: ns/op and heap
+ * allocations/op, counted by replacing the global operator new.
+ */
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+	++allocations;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+
+void operator delete(void *ptr) throw()
+{
+	free(ptr);
+}
+
+
+// Keeps the compiler from dropping the measured calls
+static volatile size_t sink = 0;
+
+
+static uint64_t nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+
+class Measure
+{
+  public:
+	Measure(const char *name, size_t size) : _name(name), _size(size), _allocs(allocations), _start(nowNs())
+	{
+	}
+
+	void stop(size_t ops)
+	{
+		uint64_t elapsed = nowNs() - _start;
+		unsigned long allocs = allocations - _allocs;
+		if (ops == 0)
+			ops = 1;
+		if (_size)
+			printf("%-40s %8lu %12.1f %12.2f\n", _name, static_cast<unsigned long>(_size),
+				static_cast<double>(elapsed) / ops, static_cast<double>(allocs) / ops);
+		else
+			printf("%-40s %8s %12.1f %12.2f\n", _name, "-",
+				static_cast<double>(elapsed) / ops, static_cast<double>(allocs) / ops);
+	}
+
+  private:
+	const char *_name;
+	size_t _size;
+	unsigned long _allocs;
+	uint64_t _start;
+};
+
+
+static void benchParser(size_t iterations)
+{
+	static const char *const lines[] = {
+		"PRIVMSG #general :hello everyone, how is it going?\r\n",
+		":alice!alice@127.0.0.1 PRIVMSG bob :hi\r\n",
+		"JOIN #general secret\r\n",
+		"USER alice 0 * :Alice Liddell\r\n",
+		"MODE #general +ok secret bob\r\n"
+	};
+	static const size_t count = sizeof(lines) / sizeof(lines[0]);
+	size_t lengths[count];
+	for (size_t i = 0; i < count; ++i)
+		lengths[i] = strlen(lines[i]);
+
+	Measure m("IrcMessage::parse", 0);
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		IrcMessage msg;
+		msg.parse(lines[i % count], lengths[i % count]);
+		sink += msg.paramCount();
+	}
+	m.stop(iterations);
+}
+
+
+static void benchFormatter(size_t iterations)
+{
+	std::string nick("alice"), prefix("alice!alice@127.0.0.1"), channel("#general");
+	std::string text("hello everyone, how is it going?");
+	std::string nickList("@alice bob carol dave eve frank grace heidi ivan judy ");
+
+	{
+		Measure m("IrcMessageFormatter::sendMsg", 0);
+		for (size_t i = 0; i < iterations; ++i)
+			sink += IrcMessageFormatter::sendMsg(prefix, channel, text).size();
+		m.stop(iterations);
+	}
+	{
+		Measure m("IrcMessageFormatter::join", 0);
+		for (size_t i = 0; i < iterations; ++i)
+			sink += IrcMessageFormatter::join(prefix, channel).size();
+		m.stop(iterations);
+	}
+	{
+		Measure m("IrcMessageFormatter::namesReply", 0);
+		for (size_t i = 0; i < iterations; ++i)
+			sink += IrcMessageFormatter::namesReply("ft_irc_server", nick, channel, nickList).size();
+		m.stop(iterations);
+	}
+	{
+		Measure m("IrcMessageFormatter::sendMsg(IrcLine)", 0);
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			IrcLine line;
+			IrcMessageFormatter::sendMsg(line, prefix, channel, text);
+			sink += line.size();
+		}
+		m.stop(iterations);
+	}
+	{
+		std::string server("ft_irc_server");
+		Measure m("IrcMessageFormatter::namesReply(IrcLine)", 0);
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			IrcLine line;
+			IrcMessageFormatter::namesReply(line, server, nick, channel, nickList);
+			sink += line.size();
+		}
+		m.stop(iterations);
+	}
+}
+
+
+static void benchNickIsValid(size_t iterations)
+{
+	static const char *const nicks[] = { "alice", "Bob_42", "[guest]", "9invalid", "waytoolongnick" };
+	std::string values[5];
+	for (size_t i = 0; i < 5; ++i)
+		values[i] = nicks[i];
+
+	Measure m("Server::nickIsValid", 0);
+	for (size_t i = 0; i < iterations; ++i)
+		sink += Server::nickIsValid(values[i % 5]);
+	m.stop(iterations);
+}
+
+
+// Membership operations on a channel of `size` members, every tenth an operator
+static void benchChannel(size_t size)
+{
+	std::vector<Client *> clients;
+	clients.reserve(size);
+	for (size_t i = 0; i < size; ++i)
+		clients.push_back(new Client(-1, "127.0.0.1", NULL));
+
+	// Lookups and removals hit members spread over the whole channel
+	size_t samples = size < 1000 ? size : 1000;
+	std::vector<Client *> picks;
+	for (size_t i = 0; i < samples; ++i)
+		picks.push_back(clients[(i * 7919) % size]);
+
+	Channel channel("#bench");
+	{
+		Measure m("Channel::addClient", size);
+		for (size_t i = 0; i < size; ++i)
+			channel.addClient(clients[i]);
+		m.stop(size);
+	}
+	for (size_t i = 0; i < size; i += 10)
+		channel.addOperator(clients[i]);
+	{
+		Measure m("Channel::hasClient", size);
+		for (size_t i = 0; i < samples; ++i)
+			sink += channel.hasClient(picks[i]);
+		m.stop(samples);
+	}
+	{
+		Measure m("Channel::isOperator", size);
+		for (size_t i = 0; i < samples; ++i)
+			sink += channel.isOperator(picks[i]);
+		m.stop(samples);
+	}
+	{
+		Measure m("Channel::removeClient", size);
+		for (size_t i = 0; i < samples; ++i)
+			channel.removeClient(picks[i]);
+		m.stop(samples);
+	}
+
+	for (size_t i = 0; i < size; ++i)
+		delete clients[i];
+}
+
+
+int main(int ac, char **av)
+{
+	size_t iterations = (ac > 1) ? strtoul(av[1], NULL, 10) : 1000000;
+	size_t maxMembers = (ac > 2) ? strtoul(av[2], NULL, 10) : 100000;
+
+	Logger::configure("off", NULL);
+
+	printf("%-40s %8s %12s %12s\n", "benchmark", "size", "ns/op", "allocs/op");
+	benchParser(iterations);
+	benchFormatter(iterations);
+	benchNickIsValid(iterations);
+	for (size_t size = 10; size <= maxMembers; size *= 10)
+		benchChannel(size);
+	return (sink == 42) ? 1 : 0;
+}
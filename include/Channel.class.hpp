@@ -7,38 +7,71 @@
 #include <set>
 #include <algorithm>
 #include <sstream>
+#include <tr1/unordered_map>
 
 #include "../include/Client.class.hpp"
+#include "../include/SharedMessage.class.hpp"
 
 class Client;
 
 class Channel {
+	public:
+        // Per-client flag bits of the membership table
+        enum {
+            MEMBER = 1 << 0,
+            OPERATOR = 1 << 1,
+            VOICE = 1 << 2,
+            INVITED = 1 << 3
+        };
+        typedef std::tr1::unordered_map<Client*, unsigned char> MemberMap;
+
+        // Channel mode bits, in the order they are listed in RPL_CHANNELMODEIS
+        enum {
+            MODE_INVITE_ONLY = 1 << 0,	// i
+            MODE_TOPIC_LOCK = 1 << 1,	// t
+            MODE_KEY = 1 << 2,			// k
+            MODE_LIMIT = 1 << 3			// l
+        };
+
 	private:
 		std::string _name;
-		std::vector<Client*> _clients;
-        std::vector<char> _modes;
+        MemberMap _members;	// members and pending invitations, one entry per client
+        size_t _memberCount;
+        unsigned int _modes;
+        std::string _modeString;	// cached "+itkl" form of _modes
+        std::string _modeParams;	// cached key and limit arguments
         std::string _key;
         int _clientLimit;
-        std::vector<Client*> _operators;
-        std::vector<Client*> _invitedClients;
         std::string _topic;
         bool _hasTopic;
-        std::set<Client*> _voicedClients;
+
+        unsigned char flagsOf(Client *client) const;
+        void setFlags(Client *client, unsigned char set, unsigned char clear);
+        void updateModeString();
 
 	public:
+        Channel();
         Channel(const std::string &name);
         ~Channel();
 
+        // ObjectPool reuse: init() names a pooled channel, recycle() empties it
+        void init(const std::string &name);
+        void recycle();
+
 		const std::string &getName() const;
 
         void addClient(Client *client);
         void removeClient(Client *client);
         bool hasClient(Client *client) const;
-        const std::vector<Client*> &getClients() const;
+        size_t getMemberCount() const;
+        const MemberMap &getMembers() const;
 
-        void setMode(char mode);
-        void unsetMode(char mode);
-        bool hasMode(char mode) const;
+        static unsigned int modeBit(char mode);
+        void setMode(unsigned int mode);
+        void unsetMode(unsigned int mode);
+        bool hasMode(unsigned int mode) const;
+        const std::string &getModeString() const;
+        const std::string &getModeParams() const;
 
         void setKey(const std::string &key);
         void unsetKey();
@@ -56,6 +89,10 @@ class Channel {
         void removeOperator(Client *client);
         bool isOperator(Client *client) const;
 
+        void addVoice(Client *client);
+        void removeVoice(Client *client);
+        bool isVoiced(Client *client) const;
+
         void inviteClient(Client *client);
         bool isInvited(Client *client) const;
         void removeInvitation(Client *client);
@@ -64,4 +101,6 @@ class Channel {
         const std::string &getTopic() const;
         bool hasTopic() const;
 	    void broadcast(const std::string& message);
+	    void broadcast(const SharedMessage& message, Client *except = NULL);
+	    void broadcast(const IrcLine& line, Client *except = NULL);
 };
@@ -6,13 +6,24 @@
 #include <set>
 #include <ctime>
 #include <sys/socket.h>
+#include <vector>
+#include <deque>
+#include <tr1/unordered_set>
 
 #include "../include/Channel.class.hpp"
+#include "../include/SharedMessage.class.hpp"
+#include "../include/LineBuffer.class.hpp"
+#include "../include/Mutex.class.hpp"
+#include "../include/TimerWheel.class.hpp"
+#include "../include/TokenBucket.class.hpp"
 
 class Channel;
+class Worker;
 
 class Client
 {
+    public:
+        typedef std::tr1::unordered_set<Channel*> ChannelSet;
 
     private:
         int _socket;
@@ -24,9 +35,19 @@ class Client
         std::string _hostname;
         std::string _servername;
         std::string _realname;
+        std::string _prefix;    // nick!user@host, refait à chaque NICK/USER
+
+        /* Tampon de réception : lignes complètes et message partiel */
+        LineBuffer _recvBuffer;
 
-        /* Tampon pour stocker les messages partiels */
-        std::string _messageBuffer;
+        /* File d'envoi : messages partagés, le premier déjà envoyé jusqu'à _sendOffset */
+        std::deque<SharedMessage> _sendQueue;
+        mutable Mutex _sendLock;  // la file est remplie par tous les workers
+        size_t _sendOffset;
+        size_t _queuedBytes;
+        Worker *_worker;
+        bool _flushScheduled;
+        bool _wantsWrite;
 
         // STATUS DU CLIENT
         bool _registered;
@@ -37,7 +58,8 @@ class Client
         bool _isOperator;
 
         // CANAUX DU CLIENT
-        std::vector<Channel*> _channels;
+        ChannelSet _channels;
+        ChannelSet _invitedTo;  // canaux où une invitation attend, retirée au recyclage
 
 
         /* Temps du dernier pong */
@@ -49,13 +71,41 @@ class Client
         /* Indique si le client a reçu un PING */
         bool pingReceived;
 
+        /* Prochaine échéance du client dans la roue de son worker :
+           fin de l'enregistrement, prochain PING ou attente du PONG */
+        TimerWheel::Timer _timer;
+
+        /* Anti-flood : chaque commande coûte des jetons, les lignes en trop
+           attendent dans le tampon de réception */
+        TokenBucket _floodBucket;
+        bool _inputQueued;  // dans la file d'entrées de son worker
+        bool _throttled;    // en attente de jetons, pas seulement de son tour
+
+        /* Déconnecté, en attente de fermeture à la fin de l'itération */
+        bool _closing;
+
+        void updatePrefix();
+
     public:
 
-        Client(int socket, char* ipAddr);
+        /* Au-delà, le client ne lit plus assez vite : il est déconnecté */
+        static const size_t MAX_SEND_QUEUE = 1024 * 1024;
+
+        /* Nombre maximum de messages envoyés par un seul writev() */
+        static const size_t MAX_IOVECS = 64;
+
+        Client(int socket, const char* ipAddr, Worker *worker);
         Client();
         ~Client();
 
+        /* Réutilisation par l'ObjectPool : init() prépare un client pour un
+           nouveau socket, recycle() le vide en gardant ses tampons alloués.
+           Le socket lui-même est fermé par le serveur */
+        void init(int socket, const char* ipAddr, Worker *worker);
+        void recycle();
+
         int getSocket() const;
+        Worker *getWorker() const;
         bool isRegistered() const;
         void setRegistered(bool status);
         bool hasSentPassword() const;
@@ -87,11 +137,16 @@ class Client
         void setRealname(const std::string &realname);
         const std::string &getIp() const;
 
+        /* Source des messages du client (nick!user@host), en cache */
+        const std::string &getPrefix() const;
+
         // A PROPOS DES CANAUX DU CLIENT
         void joinChannel(Channel *channel);
         void leaveChannel(Channel *channel);
-        bool isInChannel(const std::string &channelName) const;
-        const std::vector<Channel*> &getChannelsList() const;
+        bool isInChannel(Channel *channel) const;
+        const ChannelSet &getChannelsList() const;
+        void noteInvitation(Channel *channel);
+        void dropInvitation(Channel *channel);
 
 
 
@@ -105,13 +160,45 @@ class Client
         /* Retourne le temps du dernier pong */
         time_t getLastPongTime() const;
 
-        /* Getter pour le tampon de messages partiels */
-        std::string & getMessageBuffer();
+        /* Getter pour le tampon de réception */
+        LineBuffer & getRecvBuffer();
 
         /* Indique si le client a reçu un PING */
         bool isPingReceived() const;
         void setPingReceived(bool status);
 
+        /* Timer du client, armé par le serveur dans la roue de son worker */
+        TimerWheel::Timer &getTimer();
+
+        /* Seau de jetons anti-flood, rempli selon la configuration du serveur */
+        TokenBucket &getFloodBucket();
+        bool isInputQueued() const;
+        void setInputQueued(bool status);
+        bool isThrottled() const;
+        void setThrottled(bool status);
+        bool isClosing() const;
+        void setClosing(bool status);
+
+
+        /*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+        /*                                 SEND QUEUE                                */
+        /*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+
+        /* Ajoute un message à la file d'envoi, envoyé quand le socket est prêt.
+           Appelable depuis n'importe quel worker : le worker du client est réveillé */
+        void queueMessage(const std::string &message);
+        void queueMessage(const SharedMessage &message);
+        void queueMessage(const IrcLine &line);
+
+        /* Envoie ce qui peut l'être sans bloquer avec writev(),
+           retourne le nombre d'appels système ou -1 si le socket est mort */
+        int flushOutput();
+
+        bool hasPendingOutput() const;
+        size_t pendingOutputSize() const;
+        bool wantsWrite() const;
+        void setWantsWrite(bool status);
+
 
 };
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Mutex.class.hpp"
+#include "TokenBucket.class.hpp"
+#include <stdint.h>
+#include <tr1/unordered_map>
+
+/*
+ * Recent connections per IPv4 address, shared by every worker.
+ * Each address gets a token bucket: a connection takes a token and the
+ * tokens come back at a steady rate, so the count of recent connections
+ * decays over time. An address out of tokens is refused before anything
+ * is allocated for the connection. Addresses idle long enough to be back
+ * to a full bucket are forgotten by a periodic sweep.
+ */
+class ConnectionThrottle
+{
+  public:
+	ConnectionThrottle();
+
+	// A rate of 0 lets every connection in
+	void configure(unsigned long burst, unsigned long rate);
+
+	// Thread-safe: records a connection from address, false when it must be refused
+	bool allow(uint32_t address, unsigned long nowMs);
+
+	unsigned long rejected() const;
+	size_t trackedAddresses() const;
+
+  private:
+	static const unsigned long SWEEP_INTERVAL_MS = 10000;
+
+	struct Entry
+	{
+		TokenBucket bucket;
+		unsigned long lastSeenMs;
+	};
+	typedef std::tr1::unordered_map<uint32_t, Entry> AddressTable;
+
+	mutable Mutex _lock;
+	AddressTable _addresses;
+	unsigned long _burst;
+	unsigned long _rate;
+	unsigned long _idleMs;		// time for an empty bucket to refill completely
+	unsigned long _lastSweepMs;
+	unsigned long _rejected;
+
+	void sweep(unsigned long nowMs);
+
+	ConnectionThrottle(const ConnectionThrottle &);
+	ConnectionThrottle &operator=(const ConnectionThrottle &);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#ifdef IRC_USE_POLL
+# include <poll.h>
+#else
+# include <sys/epoll.h>
+#endif
+
+/*
+ * Small reactor abstraction over the readiness API of the platform.
+ * The default backend is epoll, so the cost of a wakeup only depends on the
+ * number of ready sockets. Building with BACKEND=poll (-DIRC_USE_POLL) falls
+ * back to poll() for systems without epoll.
+ */
+class EventLoop
+{
+  public:
+	// Interest / readiness flags
+	enum
+	{
+		READ = 1 << 0,
+		WRITE = 1 << 1,
+		EDGE = 1 << 2,	// edge-triggered registration (ignored by poll)
+		HANGUP = 1 << 3,
+		ERROR = 1 << 4
+	};
+
+	struct Event
+	{
+		int fd;
+		unsigned int events;
+	};
+
+	EventLoop();
+	~EventLoop();
+
+	bool init();
+	bool add(int fd, unsigned int interest);
+	bool modify(int fd, unsigned int interest);
+	void remove(int fd);
+	int wait(std::vector<Event> &events, int timeoutMs);
+
+	static const char *backendName();
+
+  private:
+#ifdef IRC_USE_POLL
+	std::vector<pollfd> _pollFds;
+	std::vector<int> _indexByFd;	// fd -> position in _pollFds, -1 if absent
+#else
+	int _epollFd;
+	std::vector<epoll_event> _readyEvents;
+#endif
+
+	EventLoop(const EventLoop &);
+	EventLoop &operator=(const EventLoop &);
+};
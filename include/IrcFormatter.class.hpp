@@ -1,98 +1,153 @@
 #pragma once
 
 #include "IrcCodes.hpp"
+#include "IrcLine.class.hpp"
 #include <string>
 
 class IrcMessageFormatter {
     public:
         // Limite de taille des messages IRC
-        static const size_t MAX_MESSAGE_LENGTH = 510;
+        static const size_t MAX_MESSAGE_LENGTH = IrcLine::MAX_CONTENT;
 
         // Messages d'erreur
         static std::string needMoreParams(const std::string& serverName, const std::string& command);
+        static void needMoreParams(IrcLine& out, const std::string& serverName, const std::string& command);
         static std::string genericError(const std::string& serverName, const std::string& errorCode, const std::string& details);
+        static void genericError(IrcLine& out, const std::string& serverName, const std::string& errorCode, const std::string& details);
         static std::string noSuchChannel(const std::string& serverName, const std::string& requester, const std::string& channelName);
+        static void noSuchChannel(IrcLine& out, const std::string& serverName, const std::string& requester, const std::string& channelName);
         static std::string channelOperatorRequired(const std::string& serverName, const std::string& nickname, const std::string& channelName);
+        static void channelOperatorRequired(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName);
         static std::string userNotInChannel(const std::string& serverName, const std::string& nickname, const std::string& channelName);
+        static void userNotInChannel(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName);
         static std::string unknownMode(const std::string& serverName, const std::string& nickname, char modeChar);
+        static void unknownMode(IrcLine& out, const std::string& serverName, const std::string& nickname, char modeChar);
         static std::string notOnChannel(const std::string& serverName, const std::string& channelName);
+        static void notOnChannel(IrcLine& out, const std::string& serverName, const std::string& channelName);
         static std::string noSuchNick(const std::string& serverName, const std::string& requester, const std::string& targetNick);
+        static void noSuchNick(IrcLine& out, const std::string& serverName, const std::string& requester, const std::string& targetNick);
         static std::string userAlreadyOnChannel(const std::string& serverName, const std::string& targetNick, const std::string& channelName);
+        static void userAlreadyOnChannel(IrcLine& out, const std::string& serverName, const std::string& targetNick, const std::string& channelName);
         static std::string badChannelMask(const std::string& serverName, const std::string& channelName);
+        static void badChannelMask(IrcLine& out, const std::string& serverName, const std::string& channelName);
         static std::string inviteOnlyChannel(const std::string& serverName, const std::string &nick, const std::string& channelName);
+        static void inviteOnlyChannel(IrcLine& out, const std::string& serverName, const std::string &nick, const std::string& channelName);
         static std::string badChannelKey(const std::string& serverName, const std::string& channelName);
+        static void badChannelKey(IrcLine& out, const std::string& serverName, const std::string& channelName);
         static std::string channelIsFull(const std::string& serverName, const std::string& channelName);
+        static void channelIsFull(IrcLine& out, const std::string& serverName, const std::string& channelName);
         static std::string cannotSendToChannel(const std::string& serverName, const std::string& nickname, const std::string& target);
+        static void cannotSendToChannel(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& target);
         
         // Erreurs de commandes
         static std::string invalidCapSubcommand(const std::string& serverName, const std::string& nick, const std::string& subCommand);
+        static void invalidCapSubcommand(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& subCommand);
         static std::string notRegistered(const std::string& serverName);
+        static void notRegistered(IrcLine& out, const std::string& serverName);
         static std::string unknownCommand(const std::string& serverName, const std::string& command);
+        static void unknownCommand(IrcLine& out, const std::string& serverName, const std::string& command);
         static std::string alreadyRegistered(const std::string& serverName);
+        static void alreadyRegistered(IrcLine& out, const std::string& serverName);
         static std::string passwordMismatch(const std::string& serverName);
+        static void passwordMismatch(IrcLine& out, const std::string& serverName);
         
         // Erreurs de nickname
         static std::string noNicknameGiven(const std::string& serverName);
+        static void noNicknameGiven(IrcLine& out, const std::string& serverName);
         static std::string erroneousNickname(const std::string& serverName, const std::string& newNickname);
+        static void erroneousNickname(IrcLine& out, const std::string& serverName, const std::string& newNickname);
         static std::string nicknameInUse(const std::string& serverName, const std::string& current, const std::string& newNickname);
+        static void nicknameInUse(IrcLine& out, const std::string& serverName, const std::string& current, const std::string& newNickname);
         static std::string erroneousUsername(const std::string& serverName, const std::string& username);
+        static void erroneousUsername(IrcLine& out, const std::string& serverName, const std::string& username);
         
         // Messages de bienvenue et d'information
         static std::string welcome(const std::string& serverName, const std::string& nickname, const std::string& realName, const std::string& host);
+        static void welcome(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& realName, const std::string& host);
         static std::string yourHost(const std::string& serverName, const std::string& nick, const std::string& serverVersion);
+        static void yourHost(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& serverVersion);
         static std::string serverCreated(const std::string& serverName, const std::string& nick, const std::string& creationDate);
+        static void serverCreated(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& creationDate);
         static std::string myInfo(const std::string& serverName, const std::string& nick, const std::string& version, 
             const std::string& userModes, const std::string& channelModes);
+        static void myInfo(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& version, 
+            const std::string& userModes, const std::string& channelModes);
             
         // Messages MOTD
         static std::string motdStart(const std::string& serverName, const std::string& nick);
+        static void motdStart(IrcLine& out, const std::string& serverName, const std::string& nick);
         static std::string motdLine(const std::string& serverName, const std::string& nick, const std::string& message);
+        static void motdLine(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& message);
         static std::string motdEnd(const std::string& serverName, const std::string& nick);
+        static void motdEnd(IrcLine& out, const std::string& serverName, const std::string& nick);
         static std::string modeChanged(const std::string& serverName, const std::string& channelName, const std::string& modeString);
+        static void modeChanged(IrcLine& out, const std::string& serverName, const std::string& channelName, const std::string& modeString);
 
         // Messages de canal
-        static std::string join(const std::string& nickname, const std::string& realname, const std::string& serverIp, const std::string& channelName);
-        static std::string part(const std::string& nickname, const std::string& username, const std::string& serverIp, const std::string& channelName);
+        // prefix : source du message, Client::getPrefix() (nick!user@host)
+        static std::string join(const std::string& prefix, const std::string& channelName);
+        static void join(IrcLine& out, const std::string& prefix, const std::string& channelName);
+        static std::string part(const std::string& prefix, const std::string& channelName);
+        static void part(IrcLine& out, const std::string& prefix, const std::string& channelName);
         static std::string modeChange(const std::string& nickname, const std::string& channelName, const std::string& modeString);
+        static void modeChange(IrcLine& out, const std::string& nickname, const std::string& channelName, const std::string& modeString);
         static std::string channelModeIs(const std::string& serverName, const std::string& nickname, const std::string& channelName, 
                                         const std::string& modes, const std::string& modeParams = std::string());
+        static void channelModeIs(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName, 
+                                        const std::string& modes, const std::string& modeParams = std::string());
         
         // Messages de topic
         static std::string topicReply(const std::string& serverName, const std::string& nickname, const std::string& channelName, const std::string& topic);
+        static void topicReply(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName, const std::string& topic);
         static std::string noTopicReply(const std::string& serverName, const std::string& nickname, const std::string& channelName);
+        static void noTopicReply(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName);
         static std::string topicChange(const std::string& nickname, const std::string& channelName, const std::string& topic);
+        static void topicChange(IrcLine& out, const std::string& nickname, const std::string& channelName, const std::string& topic);
         
         // Messages d'invitation
        // static std::string invite(const std::string &serverName, const std::string& nickname, const std::string& targetNick, const std::string& channelName);
-        static std::string invite(const std::string& nickname, const std::string& targetNick, const std::string& channelName); 
+        static std::string invite(const std::string& nickname, const std::string& targetNick, const std::string& channelName);
+        static void invite(IrcLine& out, const std::string& nickname, const std::string& targetNick, const std::string& channelName); 
        static std::string inviting(const std::string& serverName, const std::string& nickname, const std::string& targetNick, const std::string& channelName);
+       static void inviting(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& targetNick, const std::string& channelName);
         
         // Messages de kick
         static std::string kick(const std::string& nickname, const std::string& channelName, const std::string& targetNick, const std::string& comment);
-        static std::string quit(const std::string& nickname, const std::string& username, const std::string& serverIp, const std::string& message);
+        static void kick(IrcLine& out, const std::string& nickname, const std::string& channelName, const std::string& targetNick, const std::string& comment);
+        static std::string quit(const std::string& prefix, const std::string& message);
+        static void quit(IrcLine& out, const std::string& prefix, const std::string& message);
         
         // Messages de nick
         //static std::string nickChange(const std::string& currentNickname, const std::string& newNickname);
-        static std::string nickChange(const std::string& currentNickname, const std::string& username, const std::string &serverIp, const std::string& newNickname);
+        static std::string nickChange(const std::string& oldPrefix, const std::string& newNickname);
+        static void nickChange(IrcLine& out, const std::string& oldPrefix, const std::string& newNickname);
         
         // Messages de noms
         static std::string namesReply(const std::string& serverName, const std::string& nick, const std::string& channelName, const std::string& nickList);
+        static void namesReply(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& channelName, const std::string& nickList);
         static std::string endOfNames(const std::string& serverName, const std::string& nick, const std::string& channelName);
+        static void endOfNames(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& channelName);
         
         // Messages de capacités
         static std::string capabilityList(const std::string& serverName, const std::string& nick, const std::string& capabilities);
+        static void capabilityList(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& capabilities);
 
 	// Messages SENDER -> TARGET
         static std::string sendMsg(const std::string& sender, const std::string& target, const std::string& message);
+        static void sendMsg(IrcLine& out, const std::string& sender, const std::string& target, const std::string& message);
+
+	// Fin de connexion envoyée par le serveur
+        static std::string closingLink(const std::string& host, const std::string& reason);
+        static void closingLink(IrcLine& out, const std::string& host, const std::string& reason);
 
 	// PING/PONG
+        static std::string ping(const std::string& serverName);
+        static void ping(IrcLine& out, const std::string& serverName);
         static std::string pong(const std::string& message);
+        static void pong(IrcLine& out, const std::string& message);
 	
 
     private:
-        // Utilitaire pour tronquer et ajouter CRLF
-        static std::string formatMessage(const std::string& message);
-        
         // Constructeur privé pour empêcher l'instanciation
         IrcMessageFormatter();
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+ * One outgoing IRC line, built in place in a fixed 512-byte buffer.
+ * Appends are bounds-checked: the content stops at 510 bytes and the CRLF
+ * terminator is always kept right after it, so data()/size() are ready to be
+ * queued without another copy.
+ */
+class IrcLine
+{
+  public:
+	static const size_t MAX_CONTENT = 510;
+
+	IrcLine();
+
+	IrcLine &append(const char *bytes, size_t length);
+	IrcLine &operator<<(const std::string &text);
+	IrcLine &operator<<(const char *text);
+	IrcLine &operator<<(char c);
+	IrcLine &operator<<(long number);
+
+	// The whole line, CRLF included
+	const char *data() const;
+	size_t size() const;
+	size_t contentSize() const;
+	bool truncated() const;
+	std::string str() const;
+	void clear();
+
+  private:
+	char _buffer[MAX_CONTENT + 2];
+	size_t _length;		// content bytes, CRLF excluded
+	bool _truncated;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Non-owning view of a slice of a received line.
+ * Only valid while the buffer it points into is left untouched.
+ */
+class StringView
+{
+  public:
+	StringView();
+	StringView(const char *data, size_t size);
+
+	const char *data() const;
+	size_t size() const;
+	bool empty() const;
+	char operator[](size_t index) const;
+	std::string str() const;
+
+	bool operator==(const char *other) const;
+	bool operator==(const std::string &other) const;
+	bool operator!=(const char *other) const;
+	bool operator!=(const std::string &other) const;
+
+  private:
+	const char *_data;
+	size_t _size;
+};
+
+/*
+ * One parsed IRC line (RFC 1459, IRCv3 message tags are skipped):
+ *   [@tags] [:prefix] <command> [params...] [:trailing]
+ * Every part is a view into the line given to parse(): nothing is copied
+ * and nothing is allocated.
+ */
+class IrcMessage
+{
+  public:
+	static const size_t MAX_PARAMS = 15;
+
+	IrcMessage();
+
+	// false when the line holds no command
+	bool parse(const char *line, size_t length);
+
+	const StringView &prefix() const;
+	const StringView &command() const;
+	const StringView &param(size_t index) const;	// empty view when out of range
+	size_t paramCount() const;
+	bool hasTrailing() const;	// the last param was introduced by ':'
+
+  private:
+	StringView _prefix;
+	StringView _command;
+	StringView _params[MAX_PARAMS];
+	size_t _paramCount;
+	bool _hasTrailing;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * Fixed-size receive buffer of one client.
+ * recv() writes straight into the free space at the end, complete lines are
+ * found in place and handed out as pointers into the buffer, and only the
+ * unfinished tail is moved back to the front (compact) before the next read.
+ */
+class LineBuffer
+{
+  public:
+	// RFC 1459 lines are at most 512 bytes: room for a burst of them
+	static const size_t CAPACITY = 8192;
+
+	LineBuffer();
+
+	char *writePtr();
+	size_t writable() const;
+	void commit(size_t bytes);
+
+	// Next complete line without its terminator, valid until the next compact()
+	bool nextLine(const char *&line, size_t &length);
+	// Hands the line last returned by nextLine() back, to be read again later
+	void unread(const char *line);
+	bool hasLine() const;
+
+	void compact();
+	void clear();
+
+  private:
+	char _data[CAPACITY];
+	size_t _start;		// first unread byte
+	size_t _end;		// end of the received bytes
+	size_t _scan;		// bytes before this one hold no '\n'
+	bool _discarding;	// dropping the rest of an overlong line
+
+	LineBuffer(const LineBuffer &);
+	LineBuffer &operator=(const LineBuffer &);
+};
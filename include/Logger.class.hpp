@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+
+/*
+ * Asynchronous leveled logger.
+ * Any thread formats its line into a slot of a bounded lock-free ring; a
+ * background thread drains the ring and writes whole batches with one write()
+ * per stream. When the ring is full the line is dropped and counted instead of
+ * blocking the event loop. An idle drain thread sleeps on a condition variable;
+ * producers only take its lock to wake it up when it announced it was asleep.
+ *
+ * Levels below IRC_LOG_MIN_LEVEL are compiled out, the others are filtered at
+ * run time by level and category (IRCSERV_LOG_LEVEL, IRCSERV_LOG_CATEGORIES).
+ */
+class Logger
+{
+  public:
+	enum Level
+	{
+		DEBUG = 0,
+		INFO = 1,
+		WARN = 2,
+		ERROR = 3,
+		OFF = 4
+	};
+
+	// Subsystems, as a mask
+	enum Category
+	{
+		SERVER = 1 << 0,
+		NET = 1 << 1,
+		CLIENT = 1 << 2,
+		CHANNEL = 1 << 3,
+		COMMAND = 1 << 4,
+		ALL_CATEGORIES = (1 << 5) - 1
+	};
+
+	static const size_t RING_SIZE = 4096;	// slots, power of two
+	static const size_t LINE_SIZE = 512;	// longer lines are truncated
+
+	static bool configure(const char *level, const char *categories);
+	static void start();
+	static void stop();
+
+	static bool enabled(Level level, Category category)
+	{
+		return level >= _level && (category & _categories);
+	}
+	static void write(Level level, Category category, const std::string &text);
+	static unsigned long dropped();
+
+  private:
+	struct Slot
+	{
+		volatile size_t sequence;
+		unsigned char level;
+		unsigned char category;
+		size_t length;
+		char text[LINE_SIZE];
+	};
+
+	static Level _level;
+	static unsigned int _categories;
+	static Slot *_ring;
+	static volatile size_t _enqueuePos;
+	static size_t _dequeuePos;
+	static volatile unsigned long _dropped;
+	static bool _running;	// atomic loads and stores only
+	static pthread_t _thread;
+	static bool _sleeping;	// the drain thread found the ring empty
+	static pthread_mutex_t _wakeLock;
+	static pthread_cond_t _wakeCond;
+
+	static bool running();
+	static void *drainLoop(void *arg);
+	static size_t drain();
+	static bool hasPending();
+	static void wakeDrainThread();
+	static void append(std::string &out, Level level, Category category, const char *text, size_t length);
+
+	Logger();
+};
+
+#ifndef IRC_LOG_MIN_LEVEL
+# define IRC_LOG_MIN_LEVEL Logger::DEBUG
+#endif
+
+// The message is only formatted when the level and the category are enabled
+#define IRC_LOG(level, category, message) \
+	do { \
+		if ((level) >= IRC_LOG_MIN_LEVEL && Logger::enabled((level), (category))) \
+		{ \
+			std::ostringstream logStream_; \
+			logStream_ << message; \
+			Logger::write((level), (category), logStream_.str()); \
+		} \
+	} while (0)
+
+#define LOG_DEBUG(category, message) IRC_LOG(Logger::DEBUG, Logger::category, message)
+#define LOG_INFO(category, message) IRC_LOG(Logger::INFO, Logger::category, message)
+#define LOG_WARN(category, message) IRC_LOG(Logger::WARN, Logger::category, message)
+#define LOG_ERROR(category, message) IRC_LOG(Logger::ERROR, Logger::category, message)
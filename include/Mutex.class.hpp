@@ -0,0 +1,33 @@
+#pragma once
+
+#include <pthread.h>
+
+class Mutex
+{
+  public:
+	Mutex();
+	~Mutex();
+
+	void lock();
+	void unlock();
+
+  private:
+	pthread_mutex_t _mutex;
+
+	Mutex(const Mutex &);
+	Mutex &operator=(const Mutex &);
+};
+
+// Holds the mutex for the lifetime of the scope
+class ScopedLock
+{
+  public:
+	explicit ScopedLock(Mutex &mutex);
+	~ScopedLock();
+
+  private:
+	Mutex &_mutex;
+
+	ScopedLock(const ScopedLock &);
+	ScopedLock &operator=(const ScopedLock &);
+};
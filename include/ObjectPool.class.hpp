@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Slab allocator for the long-lived objects of the server (clients, channels).
+ * Objects are default-constructed SLAB_SIZE at a time and never destroyed
+ * before the pool: release() calls T::recycle(), which drops what the object
+ * refers to but keeps its strings and containers allocated, and the next
+ * acquire() hands the same object out again. A reconnect storm then reuses
+ * warm objects instead of going through the allocator for every connection.
+ *
+ * Not thread-safe: the server only touches its pools with _stateLock held.
+ */
+template <typename T>
+class ObjectPool
+{
+  public:
+	static const size_t SLAB_SIZE = 64;
+
+	struct Stats
+	{
+		size_t slabs;
+		size_t capacity;	// objects constructed so far
+		size_t inUse;
+		size_t peak;		// highest inUse seen
+		unsigned long acquired;
+		unsigned long reused;	// acquisitions served by a recycled object
+	};
+
+	ObjectPool() : _fresh(0)
+	{
+		Stats empty = {0, 0, 0, 0, 0, 0};
+		_stats = empty;
+	}
+
+	~ObjectPool()
+	{
+		for (size_t i = 0; i < _slabs.size(); ++i)
+			delete[] _slabs[i];
+	}
+
+	T *acquire()
+	{
+		// Released objects first, then the part of the last slab never handed out
+		T *object;
+		bool reused = !_free.empty();
+		if (reused)
+		{
+			object = _free.back();
+			_free.pop_back();
+		}
+		else
+		{
+			if (_fresh == 0)
+				grow();
+			object = &_slabs.back()[SLAB_SIZE - _fresh--];
+		}
+
+		++_stats.acquired;
+		if (reused)
+			++_stats.reused;
+		if (++_stats.inUse > _stats.peak)
+			_stats.peak = _stats.inUse;
+		return object;
+	}
+
+	void release(T *object)
+	{
+		object->recycle();
+		_free.push_back(object);
+		--_stats.inUse;
+	}
+
+	const Stats &getStats() const
+	{
+		return _stats;
+	}
+
+  private:
+	std::vector<T *> _slabs;
+	std::vector<T *> _free;	// released objects only, LIFO so the most recently used comes back first
+	size_t _fresh;			// objects of the last slab never handed out, taken in address order
+	Stats _stats;
+
+	void grow()
+	{
+		T *slab = new T[SLAB_SIZE];
+		_slabs.push_back(slab);
+		_fresh = SLAB_SIZE;
+		++_stats.slabs;
+		_stats.capacity += SLAB_SIZE;
+		_free.reserve(_stats.capacity);	// release() never reallocates
+	}
+
+	ObjectPool(const ObjectPool &);
+	ObjectPool &operator=(const ObjectPool &);
+};
@@ -1,20 +1,30 @@
 #pragma once
 
 #include "../include/Client.class.hpp"
+#include "EventLoop.class.hpp"
 #include "IrcFormatter.class.hpp"
+#include "IrcMessage.class.hpp"
+#include "Logger.class.hpp"
+#include "ConnectionThrottle.class.hpp"
+#include "Mutex.class.hpp"
+#include "ObjectPool.class.hpp"
+#include "Worker.class.hpp"
+#include "parse.hpp"
 #include <arpa/inet.h>
 #include <cerrno>
+#include <csignal>
 #include <cstdlib>
 #include <fcntl.h>
 #include <ifaddrs.h>
 #include <iostream>
+#include <list>
 #include <map>
-#include <poll.h>
 #include <sstream>
 #include <stdint.h>
 #include <string>
 #include <unistd.h>
 #include <vector>
+#include <tr1/unordered_map>
 
 class	Channel;
 class	Client;
@@ -22,71 +32,140 @@ class	Client;
 class Server
 {
   private:
-	static bool _signal;
+	static volatile sig_atomic_t _signal;
 	long _port;
 	std::string _password;
-	int _socketFd;
+	size_t _workerCount;
 
 	std::string _serverName;
 	std::string _serverIp;
 	std::string _serverVersion;
 
-	std::vector<pollfd> _pollFds;
+	// one reactor per thread, each owning the clients accepted on its listener
+	std::vector<Worker *> _workers;
 
-	std::vector<Channel *> _channels;
-	std::vector<Client *> _clients;
-	std::vector<Client *> _clientsToRemove;
+	// held by the worker that runs a handler or changes the shared state below
+	Mutex _stateLock;
 
-	std::map<std::string, void (Server::*)(Client *,
-		std::vector<std::string>)> _commandHandlers;
+	// channels in creation order, indexed by casemapped name
+	typedef std::list<Channel *> ChannelList;
+	typedef std::tr1::unordered_map<std::string, ChannelList::iterator> ChannelIndex;
+	ChannelList _channels;
+	ChannelIndex _channelIndex;
+	size_t _clientCount;
 
-	void setupCommandHandlers();
+	// casemapped nickname -> client, for every client that has sent a valid NICK
+	typedef std::tr1::unordered_map<std::string, Client *> NicknameIndex;
+	NicknameIndex _nicknames;
 
-	void acceptNewClient(void);
+	// clients and channels are recycled instead of deleted, under _stateLock
+	ObjectPool<Client> _clientPool;
+	ObjectPool<Channel> _channelPool;
+
+	// token bucket given to every client, a rate of 0 turns flood control off
+	unsigned long _floodBurst;
+	unsigned long _floodRate;
+
+	// lines a client may run per loop iteration before the next one gets its turn
+	unsigned long _commandBudget;
+
+	// recent connections per address, checked before a client is allocated
+	ConnectionThrottle _connectionThrottle;
+
+	typedef void (Server::*CommandHandler)(Client *, const IrcMessage &);
+
+	// Static description of a command: checked once before its handler runs
+	struct CommandSpec
+	{
+		const char *name;
+		CommandHandler handler;
+		size_t minParams;
+		bool needsRegistration;
+		unsigned int floodCost;
+	};
+	static const CommandSpec _commandTable[];
+	static const CommandSpec *findCommand(const StringView &name);
+
+	// Keepalive deadlines, in seconds
+	static const unsigned long REGISTRATION_TIMEOUT = 30;	// PASS/NICK/USER must be done by then
+	static const unsigned long PING_INTERVAL = 120;		// idle time before the server sends a PING
+	static const unsigned long PING_TIMEOUT = 60;			// time left to answer it
+
+	// PRIVMSG to a channel costs one more token per this many members
+	static const size_t FLOOD_FANOUT_STEP = 50;
+
+	int openListener();
+	void runWorker(Worker &worker);
+	void expireTimers(Worker &worker, std::vector<TimerWheel::Timer *> &expired);
+	void processInput(Worker &worker, Client *client);
+	void processInputQueue(Worker &worker, std::vector<int> &fds);
+	unsigned long commandCost(const IrcMessage &msg);
+	static void *workerMain(void *worker);
+	void wakeWorkers();
+
+	void acceptNewClients(Worker &worker);
+	void addNewClient(Worker &worker, int fd, const sockaddr_in &address);
 	void registerClient(Client *client);
-	void receiveNewData(int fd);
+	void receiveNewData(Worker &worker, int fd);
 	void logNewClient(Client* client);
 	void logNewConnection(int fd);
 
-	Client *getClient(int fd);
-	Client *getClientByNickname(const std::string &nickname);
-	void disconnectClient(int fd);
+	Client *getClientByNickname(const std::string &nickname) const;
+	void renameClient(Client *client, const std::string &newNick);
+	void disconnectClient(Client *client, const std::string &reason = "Leaving");
+	void reapClients(Worker &worker, std::vector<Client *> &removed);
+	void flushClient(Client *client);
+	void flushPendingOutput(Worker &worker);
 	
-	bool nickIsValid(const std::string &newNick) const;
 	bool nickIsUnique(Client *requestingClient, const std::string &newNick) const;
 
-	void handleCommand(Client *client, std::string &line);
-	void handleNick(Client *client, std::vector<std::string> args);
-	void handlePass(Client *client, std::vector<std::string> args);
-	void handleUser(Client *client, std::vector<std::string> args);
-	void handleKick(Client *client, std::vector<std::string> args);
-	void handleInvite(Client *client, std::vector<std::string> args);
-	void handleTopic(Client *client, std::vector<std::string> args);
-	void handleMode(Client *client, std::vector<std::string> args);
-	void handlePrivmsg(Client *client, std::vector<std::string> args);
-	void handleJoin(Client *client, std::vector<std::string> args);
-	void handlePart(Client *client, std::vector<std::string> args);
-	void handlePing(Client *client, std::vector<std::string> args);
-	void handlePong(Client *client, std::vector<std::string> args);
-	void handleQuit(Client *client, std::vector<std::string> args);
+	void handleCommand(Client *client, const IrcMessage &msg);
+	void handleNick(Client *client, const IrcMessage &msg);
+	void handlePass(Client *client, const IrcMessage &msg);
+	void handleUser(Client *client, const IrcMessage &msg);
+	void handleKick(Client *client, const IrcMessage &msg);
+	void handleInvite(Client *client, const IrcMessage &msg);
+	void handleTopic(Client *client, const IrcMessage &msg);
+	void handleMode(Client *client, const IrcMessage &msg);
+	void handlePrivmsg(Client *client, const IrcMessage &msg);
+	void handleJoin(Client *client, const IrcMessage &msg);
+	void handlePart(Client *client, const IrcMessage &msg);
+	void handlePing(Client *client, const IrcMessage &msg);
+	void handlePong(Client *client, const IrcMessage &msg);
+	void handleQuit(Client *client, const IrcMessage &msg);
 	
 	Channel *getChannel(const std::string &channelName);
 	Channel *createChannel(const std::string &channelName, const std::string &key, Client *client);
 	void removeChannel(const std::string &channelName);
 	void sendMessageToChannel(Client *sender, const std::string &target, const std::string &message);
 	void sendMessageToUser(Client *sender, const std::string &target, const std::string &message);
-	void printChannels(Client *client, std::vector<std::string> args);
+	void printChannels(Client *client, const IrcMessage &msg);
+	void printStats(Client *client, const IrcMessage &msg);
 
 
 	// Essai pour le bot
-	void handleBot(Client *client, std::vector<std::string> args);
-	void handleRockPaperScissors(Client *client, std::vector<std::string> args);
+	void handleBot(Client *client, const IrcMessage &msg);
+	void handleRockPaperScissors(Client *client, const IrcMessage &msg);
 
   public:
-	Server(long port, const std::string &password);
+	// Flood control defaults, overridden by IRCSERV_FLOOD_BURST / IRCSERV_FLOOD_RATE
+	static const unsigned long DEFAULT_FLOOD_BURST = 20;	// tokens
+	static const unsigned long DEFAULT_FLOOD_RATE = 5;		// tokens per second
+	static const unsigned long DEFAULT_COMMAND_BUDGET = 10;	// IRCSERV_COMMAND_BUDGET
+	// Connections per address, overridden by IRCSERV_CONN_BURST / IRCSERV_CONN_RATE
+	static const unsigned long DEFAULT_CONNECTION_BURST = 20;	// connections
+	static const unsigned long DEFAULT_CONNECTION_RATE = 2;		// connections per second
+
+	Server(long port, const std::string &password, size_t workerCount = 1);
 	~Server();
 
+	void setFloodControl(unsigned long burst, unsigned long rate);
+	void setCommandBudget(unsigned long budget);
+	void setConnectionThrottle(unsigned long burst, unsigned long rate);
 	void init();
 	void run();
 	static void signalHandler(int signum);
+
+	// Stateless, public for the microbenchmarks
+	static bool nickIsValid(const std::string &newNick);
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "IrcLine.class.hpp"
+
+/*
+ * Immutable, reference-counted bytes of a formatted IRC line.
+ * A fan-out formats a line once and every recipient's send queue holds a
+ * handle on the same block, which is freed when the last handle goes away.
+ * The count is atomic: recipients on other workers drop their handles
+ * from their own threads.
+ */
+class SharedMessage
+{
+  public:
+	SharedMessage();
+	explicit SharedMessage(const std::string &bytes);
+	SharedMessage(const char *bytes, size_t size);
+	explicit SharedMessage(const IrcLine &line);
+	SharedMessage(const SharedMessage &other);
+	SharedMessage &operator=(const SharedMessage &other);
+	~SharedMessage();
+
+	const char *data() const;
+	size_t size() const;
+	bool empty() const;
+	long useCount() const;
+
+  private:
+	// Header and bytes live in a single allocation
+	struct Block
+	{
+		long refs;
+		size_t size;
+		char bytes[1];
+	};
+
+	Block *_block;
+
+	void create(const char *bytes, size_t size);
+	void release();
+};
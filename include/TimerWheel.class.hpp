@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Hierarchical timer wheel of one worker (4 levels of 64 slots).
+ * A timer is an intrusive node owned by the object it belongs to, so
+ * schedule() and cancel() are O(1) list operations without allocation.
+ * Time is counted in ticks of TICK_MS: level 0 holds the next 64 ticks,
+ * level 1 the next 64 * 64, and so on; when level 0 wraps, the matching
+ * slot of the level above is cascaded down. Expiry is therefore only
+ * accurate to one tick, which is plenty for keepalive timeouts.
+ *
+ * Not thread-safe: only the thread of the owning worker touches it.
+ */
+class TimerWheel
+{
+  public:
+	static const unsigned long TICK_MS = 1000;
+
+	struct Timer
+	{
+		Timer *prev;
+		Timer *next;
+		unsigned long expires;	// absolute tick
+		void *owner;
+
+		Timer();
+		bool pending() const;
+	};
+
+	TimerWheel();
+
+	// Fires the timer delayMs from now, rescheduling it if it was pending
+	void schedule(Timer &timer, unsigned long delayMs);
+	void cancel(Timer &timer);
+
+	// Moves every timer due at nowMs into expired
+	void advance(unsigned long nowMs, std::vector<Timer *> &expired);
+
+	// Timeout for the event loop: -1 with no timer, else the time to the next tick
+	int timeoutMs(unsigned long nowMs) const;
+	size_t size() const;
+
+	// Monotonic clock in milliseconds
+	static unsigned long nowMs();
+
+  private:
+	static const unsigned int LEVELS = 4;
+	static const unsigned int SLOT_BITS = 6;
+	static const unsigned int SLOTS = 1 << SLOT_BITS;
+
+	Timer _slots[LEVELS][SLOTS];	// list heads, circular
+	unsigned long _current;			// last tick processed
+	size_t _count;
+
+	void insert(Timer &timer);
+	void cascade(unsigned int level, unsigned int index);
+
+	TimerWheel(const TimerWheel &);
+	TimerWheel &operator=(const TimerWheel &);
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+/*
+ * Token bucket used to rate-limit the commands of a client.
+ * Tokens are counted in thousandths so that slow rates refill smoothly
+ * with integer arithmetic. A rate of 0 disables the limit.
+ */
+class TokenBucket
+{
+  public:
+	TokenBucket();
+
+	// Full bucket of burst tokens, refilled at rate tokens per second
+	void reset(unsigned long burst, unsigned long rate, unsigned long nowMs);
+
+	// Takes cost tokens if the bucket holds them, after refilling it up to nowMs
+	bool tryTake(unsigned long cost, unsigned long nowMs);
+
+	// Time until cost tokens are available, 0 when they already are
+	unsigned long waitMs(unsigned long cost) const;
+
+  private:
+	unsigned long _milliTokens;
+	unsigned long _capacity;	// burst, in thousandths
+	unsigned long _rate;		// tokens per second, i.e. thousandths per millisecond
+	unsigned long _lastRefillMs;
+};
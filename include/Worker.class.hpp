@@ -0,0 +1,131 @@
+#pragma once
+
+#include "EventLoop.class.hpp"
+#include "Mutex.class.hpp"
+#include "TimerWheel.class.hpp"
+#include <pthread.h>
+#include <vector>
+
+class Client;
+class Server;
+
+/*
+ * One reactor thread: its own listening socket (SO_REUSEPORT when there are
+ * several workers), its own event loop and the shard of clients accepted on it.
+ * Other workers may queue output for these clients: they record the fd with
+ * scheduleFlush(), which wakes this worker through a pipe.
+ */
+class Worker
+{
+  public:
+	// Busy time of a loop iteration: bucket i counts those under 2^(i+1) us
+	static const size_t ITERATION_BUCKETS = 20;
+	// Out of descriptors: how often the listener and the warning are retried
+	static const unsigned long LISTENER_RETRY_MS = 1000;
+	static const unsigned long FD_WARNING_INTERVAL_MS = 1000;
+
+	// Debug counters, printed by PRINTSTATS from any worker: updated and
+	// copied under _statsLock
+	struct Stats
+	{
+		unsigned long commands;
+		unsigned long writeCalls;
+		unsigned long flushes;
+		unsigned long iterations;
+		unsigned long long busyUs;
+		unsigned long maxIterationUs;
+		unsigned long iterationHistogram[ITERATION_BUCKETS];
+	};
+
+	Worker(Server *server, size_t id);
+	~Worker();
+
+	bool init(int listenFd);
+
+	Server *getServer() const;
+	size_t getId() const;
+	int getListenFd() const;
+	EventLoop &getLoop();
+	TimerWheel &getTimers();
+	bool isWakeFd(int fd) const;
+
+	// fd -> client table of this shard
+	Client *getClient(int fd) const;
+	void addClient(Client *client);
+	void removeClient(int fd);
+	const std::vector<Client *> &getClients() const;
+
+	// Thread-safe: remember that the client on fd has output to flush
+	void scheduleFlush(int fd);
+	void takeFlushQueue(std::vector<int> &queue);
+	void wake();
+	void drainWakeups();
+
+	// Owner thread only: clients with complete lines left for a later
+	// iteration, runnable from readyAtMs on (now when only out of budget,
+	// later when waiting for flood tokens)
+	void queueInput(int fd, unsigned long readyAtMs);
+	void takeInputQueue(std::vector<int> &fds);
+	// Timeout for the event loop: -1 with no queued input, else the time
+	// until the first queued client can run
+	int inputTimeoutMs(unsigned long nowMs) const;
+
+	// Owner thread only, when the process is out of descriptors. A spare one
+	// is kept open so that a pending connection can still be accepted and
+	// closed (false with errno set when none was); without it, the listener
+	// leaves the loop until retryListener() runs after some descriptors were
+	// freed, or LISTENER_RETRY_MS later
+	bool refusePendingConnection();
+	void pauseListener(unsigned long nowMs);
+	bool isListenerPaused() const;
+	void retryListener(unsigned long nowMs, bool descriptorsFreed);
+	// True at most once per FD_WARNING_INTERVAL_MS, with the number of
+	// exhaustions since the last warning
+	bool fdWarningDue(unsigned long nowMs, unsigned long &count);
+
+	void bindToCurrentThread();
+	// false with errno set when the thread could not be created
+	bool start(void *(*routine)(void *));
+	void join();
+
+	// Owner thread only: clients disconnected during this iteration, closed
+	// and released once it is over
+	void scheduleRemoval(Client *client);
+	void takeClientsToRemove(std::vector<Client *> &clients);
+
+	Stats getStats() const;
+	void countCommand();
+	void countWriteCalls(unsigned long writeCalls, bool flush);
+	void recordIteration(unsigned long busyUs);
+	static unsigned long monotonicUs();
+
+  private:
+	Server *_server;
+	size_t _id;
+	int _listenFd;
+	int _reserveFd;	// /dev/null, given up to accept one connection when out of descriptors
+	bool _listenerPaused;
+	unsigned long _listenerPausedMs;
+	unsigned long _fdWarningMs;
+	unsigned long _fdExhaustions;
+	EventLoop _loop;
+	TimerWheel _timers;	// deadlines of the clients of this shard
+	std::vector<Client *> _clients;	// indexed by socket fd, NULL for free slots
+
+	Mutex _flushLock;
+	std::vector<int> _flushQueue;
+	int _wakePipe[2];
+	pthread_t _thread;
+	bool _started;
+
+	std::vector<int> _inputQueue;
+	unsigned long _inputReadyMs;	// earliest readyAtMs of the queue
+
+	std::vector<Client *> _clientsToRemove;
+
+	mutable Mutex _statsLock;
+	Stats _stats;
+
+	Worker(const Worker &);
+	Worker &operator=(const Worker &);
+};
@@ -2,4 +2,10 @@
 #include <string>
 
 long parse_port(const std::string &port_str);
-std::string parse_password(const std::string &password);
\ No newline at end of file
+std::string parse_password(const std::string &password);
+size_t parse_worker_count(const char *value);
+unsigned long parse_env_number(const char *name, unsigned long fallback, unsigned long min, unsigned long max);
+
+// RFC 1459 casemapping: A-Z and []\^ fold to a-z and {}|~
+char ircToLower(char c);
+std::string ircCasemap(const std::string &name);
@@ -7,59 +7,32 @@
 # include <iomanip>
 
 
-void	Server::handleBot(Client *client, std::vector<std::string> args)
+void	Server::handleBot(Client *client, const IrcMessage &msg)
 {
-    if (!client->isRegistered())
-    {
-        std::string response = IrcMessageFormatter::notRegistered(_serverName);
-        send(client->getSocket(), response.c_str(), response.size(), 0);
-        return ;
-    }
-
-    if (args.size() < 1)
-    {
-        std::string response = IrcMessageFormatter::needMoreParams(_serverName, "BOT");
-        send(client->getSocket(), response.c_str(), response.size(), 0);
-        return;
-    }    
+    (void)msg;
 
-    if (args[0] == "TIME")
-    {
-        const time_t now = time(0);
-        struct tm *ltm = localtime(&now);
-        std::ostringstream oss;
-        oss << "Current time is: "
-            << std::setfill('0') << std::setw(2) << ltm->tm_hour << ":"
-            << std::setfill('0') << std::setw(2) << ltm->tm_min << ":"
-            << std::setfill('0') << std::setw(2) << ltm->tm_sec;
-        std::string response = IrcMessageFormatter::genericError(_serverName, "BOT", oss.str());
-        send(client->getSocket(), response.c_str(), response.size(), 0);
-    }
-    else
-    {
-        std::string response = IrcMessageFormatter::unknownCommand(_serverName, args[1]);
-        send(client->getSocket(), response.c_str(), response.size(), 0);
-    }
+    const time_t now = time(0);
+    struct tm *ltm = localtime(&now);
+    std::ostringstream oss;
+    oss << "Current time is: "
+        << std::setfill('0') << std::setw(2) << ltm->tm_hour << ":"
+        << std::setfill('0') << std::setw(2) << ltm->tm_min << ":"
+        << std::setfill('0') << std::setw(2) << ltm->tm_sec;
+    std::string response = IrcMessageFormatter::genericError(_serverName, "BOT", oss.str());
+    client->queueMessage(response);
 }
 
-void Server::handleRockPaperScissors(Client *client, std::vector<std::string> args)
+void Server::handleRockPaperScissors(Client *client, const IrcMessage &msg)
 {
-    if (!client->isRegistered())
-    {
-        std::string response = IrcMessageFormatter::notRegistered(_serverName);
-        send(client->getSocket(), response.c_str(), response.size(), 0);
-        return ;
-    }
-
-    if (args.size() < 2 || args[0] != "RPS")
+    if (msg.paramCount() < 1)
     {
         std::string response = IrcMessageFormatter::genericError(_serverName, "BOT", 
             "Usage: BOT RPS <rock|paper|scissors>");
-        send(client->getSocket(), response.c_str(), response.size(), 0);
+        client->queueMessage(response);
         return;
     }
 
-    std::string playerMove = args[1];
+    std::string playerMove = msg.param(0).str();
     
     // Convert to lowercase for case-insensitive comparison
     std::transform(playerMove.begin(), playerMove.end(), playerMove.begin(), ::tolower);
@@ -69,7 +42,7 @@ void Server::handleRockPaperScissors(Client *client, std::vector<std::string> ar
     {
         std::string response = IrcMessageFormatter::genericError(_serverName, "BOT", 
             "Invalid move! Use: rock, paper, or scissors");
-        send(client->getSocket(), response.c_str(), response.size(), 0);
+        client->queueMessage(response);
         return;
     }
 
@@ -129,5 +102,5 @@ void Server::handleRockPaperScissors(Client *client, std::vector<std::string> ar
         oss << " 🤝";
 
     std::string response = IrcMessageFormatter::genericError(_serverName, "BOT", oss.str());
-    send(client->getSocket(), response.c_str(), response.size(), 0);
+    client->queueMessage(response);
 }
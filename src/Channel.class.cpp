@@ -1,18 +1,44 @@
 #include "../include/Channel.class.hpp"
+#include "../include/Logger.class.hpp"
+
+Channel::Channel() {
+	init("");
+};
+
 
 Channel::Channel(const std::string &name) {
+	init(name);
+};
+
+
+Channel::~Channel() {
+	LOG_DEBUG(CHANNEL, "channel destructor called: " << _name);
+	_members.clear();
+};
+
+
+/* About pooling */
+void Channel::init(const std::string &name) {
 	_name = name;
+	_memberCount = 0;
+	_modes = 0;
+	_modeString = "+";
+	_modeParams.clear();
+	_key.clear();
 	_clientLimit = -1;
+	_topic.clear();
 	_hasTopic = false;
 };
 
 
-Channel::~Channel() {
-	std::cout << "channel destructor called: " << _name << std::endl;
-	_clients.clear();
-	_operators.clear();
-	_invitedClients.clear();
-	_voicedClients.clear();
+// The table keeps its buckets for the next channel, invited clients forget this one
+void Channel::recycle() {
+	for (MemberMap::iterator it = _members.begin(); it != _members.end(); ++it) {
+		if (it->second & INVITED)
+			it->first->dropInvitation(this);
+	}
+	_members.clear();
+	init("");
 };
 
 
@@ -22,87 +48,145 @@ const std::string &Channel::getName() const {
 
 
 /* About clients */
-void Channel::addClient(Client *client) {
-	if (std::find(_clients.begin(), _clients.end(), client) == _clients.end()) {
-		_clients.push_back(client);
+unsigned char Channel::flagsOf(Client *client) const {
+	MemberMap::const_iterator it = _members.find(client);
+	return it == _members.end() ? 0 : it->second;
+};
+
+
+// Entries whose flags drop to zero are erased, so the table only holds members and invitations
+void Channel::setFlags(Client *client, unsigned char set, unsigned char clear) {
+	MemberMap::iterator it = _members.find(client);
+	unsigned char before = (it == _members.end()) ? 0 : it->second;
+	unsigned char after = (before | set) & ~clear;
+	if ((before & MEMBER) != (after & MEMBER))
+		(after & MEMBER) ? ++_memberCount : --_memberCount;
+	if (after == 0) {
+		if (it != _members.end())
+			_members.erase(it);
 	}
+	else if (it == _members.end())
+		_members.insert(std::make_pair(client, after));
+	else
+		it->second = after;
 };
 
 
+void Channel::addClient(Client *client) {
+	setFlags(client, MEMBER, 0);
+};
+
+
+// Leaving the channel drops op and voice with the membership, a pending invitation is kept
 void Channel::removeClient(Client *client) {
-	std::vector<Client *>::iterator ite = _clients.end();
-	for (std::vector<Client *>::iterator it = _clients.begin(); it != ite; ++it)
-	{
-		if (*it == client) {
-			_clients.erase(it);
-			std::cout << "Channel removed Client " << client->getSocket() << " removed from channel client list: " << this->_name << std::endl;
-			return;
-		}
-	}
-	return ;
+	if (!hasClient(client))
+		return ;
+	setFlags(client, 0, MEMBER | OPERATOR | VOICE);
+	LOG_DEBUG(CHANNEL, "Channel removed Client " << client->getSocket() << " removed from channel client list: " << this->_name);
 };
 
 
 bool Channel::hasClient(Client *client) const {
-	return std::find(_clients.begin(), _clients.end(), client) != _clients.end();
+	return flagsOf(client) & MEMBER;
+};
+
+
+size_t Channel::getMemberCount() const {
+	return _memberCount;
 };
 
 
-const std::vector<Client*> & Channel::getClients() const {
-	return _clients;
+// Entries without the MEMBER bit are pending invitations
+const Channel::MemberMap & Channel::getMembers() const {
+	return _members;
 };
 
 
 /* About modes */
-void Channel::setMode(char mode) {
-	if (mode == 'o' || mode == 'v' || mode == 'i' || mode == 'k' || mode == 'l' || mode == 't') {
-		if (std::find(_modes.begin(), _modes.end(), mode) == _modes.end()) {
-			_modes.push_back(mode);
-		}
-	} else {
-		std::cerr << "Invalid mode: " << mode << std::endl;
-	}	
+// Returns 0 for characters that are not channel-wide modes (o is a member flag)
+unsigned int Channel::modeBit(char mode) {
+	switch (mode) {
+		case 'i': return MODE_INVITE_ONLY;
+		case 't': return MODE_TOPIC_LOCK;
+		case 'k': return MODE_KEY;
+		case 'l': return MODE_LIMIT;
+		default: return 0;
+	}
 };
 
 
-void Channel::unsetMode(char mode) {
-	if (mode == 'o' || mode == 'v' || mode == 'i' || mode == 'k' || mode == 'l' || mode == 't') {
-		std::vector<char>::iterator it = std::find(_modes.begin(), _modes.end(), mode);
-		if (it != _modes.end()) {
-			_modes.erase(it);
-		}
-	} else {
-		std::cerr << "Invalid mode: " << mode << std::endl;
-	}	
+void Channel::setMode(unsigned int mode) {
+	if ((_modes | mode) != _modes) {
+		_modes |= mode;
+		updateModeString();
+	}
+};
+
+
+void Channel::unsetMode(unsigned int mode) {
+	if (_modes & mode) {
+		_modes &= ~mode;
+		updateModeString();
+	}
 };
 
 
-bool Channel::hasMode(char mode) const {
-	return std::find(_modes.begin(), _modes.end(), mode) != _modes.end();
+bool Channel::hasMode(unsigned int mode) const {
+	return (_modes & mode) != 0;
+};
+
+
+const std::string &Channel::getModeString() const {
+	return _modeString;
+};
+
+
+const std::string &Channel::getModeParams() const {
+	return _modeParams;
+};
+
+
+// Rebuilt only when a mode, the key or the limit changes, not on every MODE query
+void Channel::updateModeString() {
+	static const char letters[] = "itkl";
+
+	_modeString = "+";
+	for (size_t i = 0; letters[i]; ++i) {
+		if (_modes & (1u << i))
+			_modeString += letters[i];
+	}
+	std::ostringstream params;
+	if (_modes & MODE_KEY)
+		params << _key;
+	if (_modes & MODE_LIMIT) {
+		if (_modes & MODE_KEY)
+			params << " ";
+		params << _clientLimit;
+	}
+	_modeParams = params.str();
 };
 
 
 /* About key */
 void Channel::setKey(const std::string &key) {
 	if (key.empty()) {
-		std::cerr << "Key cannot be empty." << std::endl;
+		LOG_DEBUG(CHANNEL, "Key cannot be empty.");
 		return;
 	}
 	if (key.length() > 64) {
-		std::cerr << "Key too long, must be less than 64 characters." << std::endl;
+		LOG_WARN(CHANNEL, "Key too long, must be less than 64 characters.");
 		return;
 	}
 	_key = key;
+	_modes |= MODE_KEY;
+	updateModeString();
 };
 
 
 void Channel::unsetKey() {
 	_key.clear();
-	std::vector<char>::iterator it = std::find(_modes.begin(), _modes.end(), 'k');
-	if (it != _modes.end()) {
-		_modes.erase(it);
-	}
-	std::cout << "Key for channel " << _name << " has been unset." << std::endl;
+	unsetMode(MODE_KEY);
+	LOG_DEBUG(CHANNEL, "Key for channel " << _name << " has been unset.");
 };
 
 
@@ -124,23 +208,21 @@ const std::string &	Channel::getKey() const {
 /* About limits and status of the channel */
 void Channel::setClientLimit(int limit) {
 	if (limit < 0) {
-		std::cerr << "Client limit must be positive." << std::endl;
+		LOG_WARN(CHANNEL, "Client limit must be positive.");
 		return;
 	}
 	_clientLimit = limit;
-	if (limit > 0) {
-		if (std::find(_modes.begin(), _modes.end(), 'l') == _modes.end()) {
-			_modes.push_back('l');
-		}
-	} else {
-		_modes.erase(std::remove(_modes.begin(), _modes.end(), 'l'), _modes.end());
-	}
+	if (limit > 0)
+		_modes |= MODE_LIMIT;
+	else
+		_modes &= ~MODE_LIMIT;
+	updateModeString();
 };
 
 
 void Channel::unsetClientLimit() {
 	_clientLimit = -1;
-	_modes.erase(std::remove(_modes.begin(), _modes.end(), 'l'), _modes.end());
+	unsetMode(MODE_LIMIT);
 };
 
 
@@ -150,64 +232,80 @@ int Channel::getClientLimit() const {
 
 
 bool Channel::isFull() const {
-	return _clientLimit > 0 && _clients.size() >= static_cast<size_t>(_clientLimit);	
+	return _clientLimit > 0 && _memberCount >= static_cast<size_t>(_clientLimit);	
 };
 
 
 bool Channel::isEmpty() const {
-	return _clients.empty();
+	return _memberCount == 0;
 };
 
 
 /* About operator */
 void Channel::addOperator(Client *client) {
-	if (std::find(_operators.begin(), _operators.end(), client) == _operators.end()) {
-		_operators.push_back(client);
+	if (hasClient(client) && !isOperator(client)) {
+		setFlags(client, OPERATOR, 0);
 		client->setOperator(true);
-		std::cout << "Client " << client->getSocket() << " is now an operator in channel: " << this->_name << std::endl;
+		LOG_DEBUG(CHANNEL, "Client " << client->getSocket() << " is now an operator in channel: " << this->_name);
 	}
 };
 
 
 void Channel::removeOperator(Client *client) {
-	if (std::find(_operators.begin(), _operators.end(), client) != _operators.end()) {
-		_operators.erase(std::remove(_operators.begin(), _operators.end(), client), _operators.end());
+	if (isOperator(client)) {
+		setFlags(client, 0, OPERATOR);
 		client->setOperator(false);
-		std::cout << "Client " << client->getSocket() << " is no longer an operator in channel: " << this->_name << std::endl;
+		LOG_DEBUG(CHANNEL, "Client " << client->getSocket() << " is no longer an operator in channel: " << this->_name);
 	}
 };
 
 
 bool Channel::isOperator(Client *client) const {
-	return std::find(_operators.begin(), _operators.end(), client) != _operators.end();
+	return flagsOf(client) & OPERATOR;
 };
 
 
+/* About voice */
+void Channel::addVoice(Client *client) {
+	if (hasClient(client))
+		setFlags(client, VOICE, 0);
+};
+
+
+void Channel::removeVoice(Client *client) {
+	setFlags(client, 0, VOICE);
+};
+
+
+bool Channel::isVoiced(Client *client) const {
+	return flagsOf(client) & VOICE;
+};
+
+
+/* About invitations */
 void Channel::inviteClient(Client *client) {
-	std::vector<Client *>::iterator it = std::find(_invitedClients.begin(), _invitedClients.end(), client);
-	if (it == _invitedClients.end()) {
-		_invitedClients.push_back(client);
-	
-		std::cout << "Client " << client->getSocket() << " has been invited to channel: " << this->_name << std::endl;
+	if (!isInvited(client)) {
+		setFlags(client, INVITED, 0);
+		client->noteInvitation(this);
+		LOG_DEBUG(CHANNEL, "Client " << client->getSocket() << " has been invited to channel: " << this->_name);
 	} else {
-		std::cerr << "Client " << client->getSocket() << " is already invited to channel: " << this->_name << std::endl;
+		LOG_WARN(CHANNEL, "Client " << client->getSocket() << " is already invited to channel: " << this->_name);
 	}
 };
 
 
 bool Channel::isInvited(Client *client) const {
-	std::vector<Client *>::const_iterator it = std::find(_invitedClients.begin(), _invitedClients.end(), client);
-	return it != _invitedClients.end();
+	return flagsOf(client) & INVITED;
 };
 
 
 void Channel::removeInvitation(Client *client) {
-	std::vector<Client *>::iterator it = std::find(_invitedClients.begin(), _invitedClients.end(), client);
-	if (it != _invitedClients.end()) {
-		_invitedClients.erase(it);
-		std::cout << "Client " << client->getSocket() << " invitation removed from channel: " << this->_name << std::endl;
+	if (isInvited(client)) {
+		setFlags(client, 0, INVITED);
+		client->dropInvitation(this);
+		LOG_DEBUG(CHANNEL, "Client " << client->getSocket() << " invitation removed from channel: " << this->_name);
 	} else {
-		std::cerr << "Client " << client->getSocket() << " is not invited to channel: " << this->_name << std::endl;
+		LOG_WARN(CHANNEL, "Client " << client->getSocket() << " is not invited to channel: " << this->_name);
 	}
 };
 
@@ -215,11 +313,11 @@ void Channel::removeInvitation(Client *client) {
 /* About topic */
 void Channel::setTopic(const std::string &topic) {
 	if (topic.empty()) {
-		std::cerr << "Topic cannot be empty." << std::endl;
+		LOG_WARN(CHANNEL, "Topic cannot be empty.");
 		return;
 	}
 	if (topic.length() > 512) {
-		std::cerr << "Topic too long, must be less than 512 characters." << std::endl;
+		LOG_WARN(CHANNEL, "Topic too long, must be less than 512 characters.");
 		return;
 	}
 	_topic = topic;
@@ -239,10 +337,24 @@ bool Channel::hasTopic() const {
 
 void	Channel::broadcast(const std::string& message)
 {
-	std::vector<Client*>::iterator it = _clients.begin();
-	while (it != _clients.end())
+	broadcast(SharedMessage(message));
+}
+
+
+void	Channel::broadcast(const IrcLine& line, Client *except)
+{
+	broadcast(SharedMessage(line), except);
+}
+
+
+// Every member queues a reference to the same bytes
+void	Channel::broadcast(const SharedMessage& message, Client *except)
+{
+	MemberMap::const_iterator it = _members.begin();
+	while (it != _members.end())
 	{
-		send((*it)->getSocket(), message.c_str(), message.size(), 0);
+		if ((it->second & MEMBER) && it->first != except)
+			it->first->queueMessage(message);
 		it++;
 	}
 }
@@ -1,35 +1,93 @@
 #include "../include/Client.class.hpp"
-
-Client::Client(int socket, char* ipAddr)
-    : _socket(socket),  _ipAddr(ipAddr), _messageBuffer(""), _registered(false), _sentPassword(false), _sentNickname(false), 
+#include "../include/Worker.class.hpp"
+#include "../include/Logger.class.hpp"
+#include <cerrno>
+#include <sys/uio.h>
+
+Client::Client(int socket, const char* ipAddr, Worker *worker)
+    : _socket(socket),  _ipAddr(ipAddr), _sendOffset(0), _queuedBytes(0), _worker(worker),
+        _flushScheduled(false), _wantsWrite(false), _registered(false), _sentPassword(false), _sentNickname(false), 
         _sentUsername(false), _isAway(false), _isOperator(false), _lastPongTime(0),
-        _lastActivityTime(time(NULL)), pingReceived(false)
+        _lastActivityTime(time(NULL)), pingReceived(false), _inputQueued(false), _throttled(false), _closing(false)
 {
     _lastActivityTime = time(NULL);
-	std::cout << "------------------------------" << std::endl;
-    	std::cout << "📢 New Client Connected!" << std::endl;
-    	std::cout << "Socket: " << socket << std::endl;
-    	std::cout << "IP Address: " << ipAddr << std::endl;
-    	std::cout << "------------------------------" << std::endl;
+    _timer.owner = this;
+    LOG_DEBUG(CLIENT, "📢 New Client Connected! Socket: " << socket << " IP Address: " << ipAddr);
 }
 
-Client::Client() {}
+Client::Client()
+    : _socket(-1), _sendOffset(0), _queuedBytes(0), _worker(NULL),
+        _flushScheduled(false), _wantsWrite(false), _registered(false), _sentPassword(false), _sentNickname(false),
+        _sentUsername(false), _isAway(false), _isOperator(false), _lastPongTime(0),
+        _lastActivityTime(0), pingReceived(false), _inputQueued(false), _throttled(false), _closing(false)
+{
+    _timer.owner = this;
+}
 
 
 Client::~Client()
 {
-	// Close the clients fd
-    shutdown(_socket, SHUT_RDWR);
-    close(_socket);
+    _channels.clear();
+}
+
+
+/**
+ * @description Gives a pooled client to a newly accepted socket.
+ * Every field is reset here, the strings keep the capacity of their last use.
+ */
+void Client::init(int socket, const char* ipAddr, Worker *worker)
+{
+    _socket = socket;
+    _ipAddr = ipAddr;
+    _worker = worker;
+    _sendOffset = 0;
+    _queuedBytes = 0;
+    _flushScheduled = false;
+    _wantsWrite = false;
+    _registered = false;
+    _sentPassword = false;
+    _sentNickname = false;
+    _sentUsername = false;
+    _isAway = false;
+    _isOperator = false;
+    _lastPongTime = 0;
+    _lastActivityTime = time(NULL);
+    pingReceived = false;
+    _inputQueued = false;
+    _throttled = false;
+    _closing = false;
+    LOG_DEBUG(CLIENT, "📢 New Client Connected! Socket: " << socket << " IP Address: " << ipAddr);
+}
 
+
+/**
+ * @description Empties a disconnected client before it goes back to the pool.
+ * Pending invitations are withdrawn, so that the next user of this object
+ * does not inherit them.
+ */
+void Client::recycle()
+{
+    ChannelSet invitations;
+    invitations.swap(_invitedTo);
+    for (ChannelSet::iterator it = invitations.begin(); it != invitations.end(); ++it)
+        (*it)->removeInvitation(this);
+
+    _nickname.clear();
+    _username.clear();
+    _hostname.clear();
+    _servername.clear();
+    _realname.clear();
+    _prefix.clear();
+    _recvBuffer.clear();
+    {
+        ScopedLock lock(_sendLock);
+        _sendQueue.clear();
+        _sendOffset = 0;
+        _queuedBytes = 0;
+    }
     _channels.clear();
-	std::cout << "------------------------------" << std::endl;
-    	std::cout << "📢 Client Disconnected!" << std::endl;
-    	std::cout << "Nickname: " << _nickname << std::endl;
-    	std::cout << "Real Name: " << _realname << std::endl;
-    	std::cout << "IP Address: " << _ipAddr << std::endl;
-    	std::cout << "Socket: " << _socket << std::endl;
-    	std::cout << "------------------------------" << std::endl;
+    _socket = -1;
+    _worker = NULL;
 }
 
 
@@ -38,11 +96,41 @@ int Client::getSocket() const
     return _socket;
 }
 
+
+/**
+ * @return the worker whose event loop owns the socket of the client
+ */
+Worker *Client::getWorker() const
+{
+    return _worker;
+}
+
 const std::string &	Client::getIp() const
 {
 	return _ipAddr;
 }
 
+
+/**
+ * @return the source of the messages of the client, nick!user@host
+ */
+const std::string &Client::getPrefix() const
+{
+    return _prefix;
+}
+
+
+/**
+ * Rebuild the cached prefix, once per NICK/USER instead of once per message
+ */
+void Client::updatePrefix()
+{
+    _prefix = _nickname;
+    if (!_username.empty())
+        _prefix += "!" + _username;
+    _prefix += "@" + _ipAddr;
+}
+
 bool Client::isRegistered() const
 {
     return _registered;
@@ -84,11 +172,11 @@ void Client::setSentPassword(bool status)
 
 
 /**
- * @return the message buffer of the client
+ * @return the receive buffer of the client
  */
-std::string& Client::getMessageBuffer()
+LineBuffer& Client::getRecvBuffer()
 { 
-    return _messageBuffer; 
+    return _recvBuffer; 
 }
 
 
@@ -138,6 +226,7 @@ const std::string &Client::getNickname() const
 void Client::setNickname(const std::string &nickname)
 {
     _nickname = nickname;
+    updatePrefix();
 }
 
 
@@ -150,6 +239,7 @@ const std::string &Client::getUsername() const
 void Client::setUsername(const std::string &username)
 {
     _username = username;
+    updatePrefix();
 }
 
 
@@ -191,37 +281,37 @@ void Client::setRealname(const std::string &realname)
 
 void Client::joinChannel(Channel *channel)
 {
-    _channels.push_back(channel);
+    _channels.insert(channel);
 }
 
 
 void Client::leaveChannel(Channel *channel)
 {
-     std::vector<Channel*>::iterator ite = _channels.end();
-    for (std::vector<Channel*>::iterator it = _channels.begin(); it != ite; ++it)
-    {
-        if ((*it)->getName() == channel->getName()) {
-		std::cout << _nickname << " removing channel from its channel list: " << channel->getName() << std::endl;
-            _channels.erase(it);
-        	return;
-	}
-    }
+    if (_channels.erase(channel))
+        LOG_DEBUG(CLIENT, _nickname << " removing channel from its channel list: " << channel->getName());
 }
 
 
-bool Client::isInChannel(const std::string &channelName) const
+// Channels are unique objects, so the pointer identifies them without comparing names
+bool Client::isInChannel(Channel *channel) const
 {
-    std::vector<Channel*>::const_iterator ite = _channels.end();
-    for (std::vector<Channel*>::const_iterator it = _channels.begin(); it != ite; ++it)
-    {
-        if ((*it)->getName() == channelName)
-            return true;
-    }
-    return false;
+    return _channels.count(channel) != 0;
+}
+
+
+void Client::noteInvitation(Channel *channel)
+{
+    _invitedTo.insert(channel);
+}
+
+
+void Client::dropInvitation(Channel *channel)
+{
+    _invitedTo.erase(channel);
 }
 
 
-const std::vector<Channel*> &Client::getChannelsList() const
+const Client::ChannelSet &Client::getChannelsList() const
 {
     return _channels;
 }
@@ -292,3 +382,179 @@ void Client::setPingReceived(bool status)
 {
     pingReceived = status;
 }
+
+
+TimerWheel::Timer &Client::getTimer()
+{
+    return _timer;
+}
+
+
+TokenBucket &Client::getFloodBucket()
+{
+    return _floodBucket;
+}
+
+
+bool Client::isInputQueued() const
+{
+    return _inputQueued;
+}
+
+
+void Client::setInputQueued(bool status)
+{
+    _inputQueued = status;
+}
+
+
+bool Client::isThrottled() const
+{
+    return _throttled;
+}
+
+
+void Client::setThrottled(bool status)
+{
+    _throttled = status;
+}
+
+
+bool Client::isClosing() const
+{
+    return _closing;
+}
+
+
+void Client::setClosing(bool status)
+{
+    _closing = status;
+}
+
+
+/**
+ * Append a message to the send queue. The worker of the client is told once
+ * that it has output to flush, at the end of its current loop iteration.
+ * Safe to call from any worker thread.
+ */
+void Client::queueMessage(const std::string &message)
+{
+    if (message.empty())
+        return;
+    queueMessage(SharedMessage(message));
+}
+
+
+/**
+ * Queue a line formatted in place: its bytes are copied once, into the
+ * block held by the queue
+ */
+void Client::queueMessage(const IrcLine &line)
+{
+    queueMessage(SharedMessage(line));
+}
+
+
+/**
+ * Queue a line shared with other recipients: only a reference is stored
+ */
+void Client::queueMessage(const SharedMessage &message)
+{
+    if (message.empty())
+        return;
+    ScopedLock lock(_sendLock);
+    _sendQueue.push_back(message);
+    _queuedBytes += message.size();
+    if (!_flushScheduled && _worker)
+    {
+        _flushScheduled = true;
+        _worker->scheduleFlush(_socket);
+    }
+}
+
+
+/**
+ * Send as much of the queue as the socket accepts without blocking.
+ * The queued lines are gathered so that one writev() sends the whole batch.
+ * @return the number of write syscalls made, -1 if the connection is broken
+ */
+int Client::flushOutput()
+{
+    int syscalls = 0;
+    ScopedLock lock(_sendLock);
+    _flushScheduled = false;	// anything queued from now on needs another flush
+
+    while (!_sendQueue.empty())
+    {
+        struct iovec iov[MAX_IOVECS];
+        size_t count = 0;
+        size_t batchBytes = 0;
+        std::deque<SharedMessage>::const_iterator it = _sendQueue.begin();
+        for (; it != _sendQueue.end() && count < MAX_IOVECS; ++it, ++count)
+        {
+            size_t skip = (count == 0) ? _sendOffset : 0;
+            iov[count].iov_base = const_cast<char *>(it->data() + skip);
+            iov[count].iov_len = it->size() - skip;
+            batchBytes += iov[count].iov_len;
+        }
+
+        ssize_t sent = writev(_socket, iov, count);
+        syscalls++;
+        if (sent == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return -1;
+        }
+
+        // Drop the lines that were fully written, remember where the next one stopped
+        _queuedBytes -= sent;
+        size_t remaining = sent;
+        while (remaining > 0)
+        {
+            size_t left = _sendQueue.front().size() - _sendOffset;
+            if (remaining < left)
+            {
+                _sendOffset += remaining;
+                break;
+            }
+            remaining -= left;
+            _sendQueue.pop_front();	// drops our reference on the shared line
+            _sendOffset = 0;
+        }
+        if (static_cast<size_t>(sent) < batchBytes)
+            break;	// the socket buffer is full
+    }
+    return syscalls;
+}
+
+
+bool Client::hasPendingOutput() const
+{
+    ScopedLock lock(_sendLock);
+    return !_sendQueue.empty();
+}
+
+
+size_t Client::pendingOutputSize() const
+{
+    ScopedLock lock(_sendLock);
+    return _queuedBytes;
+}
+
+
+/**
+ * @return true if the server watches this socket for writability
+ */
+bool Client::wantsWrite() const
+{
+    return _wantsWrite;
+}
+
+
+void Client::setWantsWrite(bool status)
+{
+    _wantsWrite = status;
+}
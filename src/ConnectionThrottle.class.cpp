@@ -0,0 +1,68 @@
+#include "../include/ConnectionThrottle.class.hpp"
+
+ConnectionThrottle::ConnectionThrottle()
+	: _burst(0), _rate(0), _idleMs(0), _lastSweepMs(0), _rejected(0)
+{
+}
+
+
+void ConnectionThrottle::configure(unsigned long burst, unsigned long rate)
+{
+	ScopedLock lock(_lock);
+	_burst = burst;
+	_rate = rate;
+	_idleMs = rate ? (burst * 1000 + rate - 1) / rate : 0;
+	_addresses.clear();
+}
+
+
+bool ConnectionThrottle::allow(uint32_t address, unsigned long nowMs)
+{
+	ScopedLock lock(_lock);
+	if (_rate == 0)
+		return true;
+	if (nowMs - _lastSweepMs >= SWEEP_INTERVAL_MS)
+		sweep(nowMs);
+
+	AddressTable::iterator it = _addresses.find(address);
+	if (it == _addresses.end())
+	{
+		Entry entry;
+		entry.bucket.reset(_burst, _rate, nowMs);
+		it = _addresses.insert(std::make_pair(address, entry)).first;
+	}
+	it->second.lastSeenMs = nowMs;
+	if (it->second.bucket.tryTake(1, nowMs))
+		return true;
+	++_rejected;
+	return false;
+}
+
+
+// Amortized: one pass over the table every SWEEP_INTERVAL_MS at most
+void ConnectionThrottle::sweep(unsigned long nowMs)
+{
+	_lastSweepMs = nowMs;
+	AddressTable::iterator it = _addresses.begin();
+	while (it != _addresses.end())
+	{
+		if (nowMs - it->second.lastSeenMs >= _idleMs)
+			it = _addresses.erase(it);
+		else
+			++it;
+	}
+}
+
+
+unsigned long ConnectionThrottle::rejected() const
+{
+	ScopedLock lock(_lock);
+	return _rejected;
+}
+
+
+size_t ConnectionThrottle::trackedAddresses() const
+{
+	ScopedLock lock(_lock);
+	return _addresses.size();
+}
@@ -0,0 +1,220 @@
+#include "../include/EventLoop.class.hpp"
+#include <cerrno>
+#include <unistd.h>
+
+#ifdef IRC_USE_POLL
+
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+/*                               POLL BACKEND                                */
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+
+static short toPollEvents(unsigned int interest)
+{
+	short events = 0;
+	if (interest & EventLoop::READ)
+		events |= POLLIN;
+	if (interest & EventLoop::WRITE)
+		events |= POLLOUT;
+	return events;
+}
+
+
+EventLoop::EventLoop()
+{
+}
+
+
+EventLoop::~EventLoop()
+{
+}
+
+
+bool EventLoop::init()
+{
+	return true;
+}
+
+
+bool EventLoop::add(int fd, unsigned int interest)
+{
+	if (fd < 0)
+		return false;
+	if (static_cast<size_t>(fd) >= _indexByFd.size())
+		_indexByFd.resize(fd + 1, -1);
+	if (_indexByFd[fd] != -1)
+		return modify(fd, interest);
+
+	struct pollfd entry;
+	entry.fd = fd;
+	entry.events = toPollEvents(interest);
+	entry.revents = 0;
+	_indexByFd[fd] = _pollFds.size();
+	_pollFds.push_back(entry);
+	return true;
+}
+
+
+bool EventLoop::modify(int fd, unsigned int interest)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _indexByFd.size() || _indexByFd[fd] == -1)
+		return false;
+	_pollFds[_indexByFd[fd]].events = toPollEvents(interest);
+	return true;
+}
+
+
+// O(1): the last entry is moved into the freed slot
+void EventLoop::remove(int fd)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _indexByFd.size() || _indexByFd[fd] == -1)
+		return;
+	size_t index = _indexByFd[fd];
+	size_t last = _pollFds.size() - 1;
+	if (index != last)
+	{
+		_pollFds[index] = _pollFds[last];
+		_indexByFd[_pollFds[index].fd] = index;
+	}
+	_pollFds.pop_back();
+	_indexByFd[fd] = -1;
+}
+
+
+int EventLoop::wait(std::vector<Event> &events, int timeoutMs)
+{
+	events.clear();
+	if (poll(_pollFds.empty() ? NULL : &_pollFds[0], _pollFds.size(), timeoutMs) == -1)
+		return (errno == EINTR) ? 0 : -1;
+
+	// Snapshot the ready entries so callers can add/remove fds while handling them
+	for (size_t i = 0; i < _pollFds.size(); ++i)
+	{
+		short revents = _pollFds[i].revents;
+		if (revents == 0)
+			continue;
+		Event ev;
+		ev.fd = _pollFds[i].fd;
+		ev.events = 0;
+		if (revents & POLLIN)
+			ev.events |= READ;
+		if (revents & POLLOUT)
+			ev.events |= WRITE;
+		if (revents & POLLHUP)
+			ev.events |= HANGUP;
+		if (revents & (POLLERR | POLLNVAL))
+			ev.events |= ERROR;
+		events.push_back(ev);
+	}
+	return events.size();
+}
+
+
+const char *EventLoop::backendName()
+{
+	return "poll";
+}
+
+#else
+
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+/*                              EPOLL BACKEND                                */
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+
+static uint32_t toEpollEvents(unsigned int interest)
+{
+	uint32_t events = 0;
+	if (interest & EventLoop::READ)
+		events |= EPOLLIN | EPOLLRDHUP;
+	if (interest & EventLoop::WRITE)
+		events |= EPOLLOUT;
+	if (interest & EventLoop::EDGE)
+		events |= EPOLLET;
+	return events;
+}
+
+
+EventLoop::EventLoop() : _epollFd(-1), _readyEvents(256)
+{
+}
+
+
+EventLoop::~EventLoop()
+{
+	if (_epollFd >= 0)
+		close(_epollFd);
+}
+
+
+bool EventLoop::init()
+{
+	_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	return _epollFd >= 0;
+}
+
+
+bool EventLoop::add(int fd, unsigned int interest)
+{
+	struct epoll_event ev;
+	ev.events = toEpollEvents(interest);
+	ev.data.fd = fd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) == 0)
+		return true;
+	if (errno == EEXIST)
+		return modify(fd, interest);
+	return false;
+}
+
+
+bool EventLoop::modify(int fd, unsigned int interest)
+{
+	struct epoll_event ev;
+	ev.events = toEpollEvents(interest);
+	ev.data.fd = fd;
+	return epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+
+void EventLoop::remove(int fd)
+{
+	struct epoll_event ev;	// ignored, but required by kernels older than 2.6.9
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+
+int EventLoop::wait(std::vector<Event> &events, int timeoutMs)
+{
+	events.clear();
+	int count = epoll_wait(_epollFd, &_readyEvents[0], _readyEvents.size(), timeoutMs);
+	if (count == -1)
+		return (errno == EINTR) ? 0 : -1;
+
+	for (int i = 0; i < count; ++i)
+	{
+		uint32_t revents = _readyEvents[i].events;
+		Event ev;
+		ev.fd = _readyEvents[i].data.fd;
+		ev.events = 0;
+		if (revents & EPOLLIN)
+			ev.events |= READ;
+		if (revents & EPOLLOUT)
+			ev.events |= WRITE;
+		if (revents & (EPOLLHUP | EPOLLRDHUP))
+			ev.events |= HANGUP;
+		if (revents & EPOLLERR)
+			ev.events |= ERROR;
+		events.push_back(ev);
+	}
+
+	// The ready list was full: let the next wakeup report more at once
+	if (static_cast<size_t>(count) == _readyEvents.size())
+		_readyEvents.resize(_readyEvents.size() * 2);
+	return count;
+}
+
+
+const char *EventLoop::backendName()
+{
+	return "epoll";
+}
+
+#endif
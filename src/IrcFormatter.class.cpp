@@ -1,183 +1,415 @@
 #include "IrcFormatter.class.hpp"
 #include <sstream>
 
-// fonction principale
-std::string IrcMessageFormatter::formatMessage(const std::string& message) {
-    if (message.length() > MAX_MESSAGE_LENGTH) {
-        return message.substr(0, MAX_MESSAGE_LENGTH) + "\r\n";
-    }
-    return message + "\r\n";
-}
+/*
+ * Chaque message existe en deux versions : l'une écrit directement dans un
+ * IrcLine fourni par l'appelant (tronqué à 510 octets, CRLF ajouté sur place,
+ * aucune allocation), l'autre la copie dans une std::string.
+ */
 
 // Messages d'erreur de paramètres
+void IrcMessageFormatter::needMoreParams(IrcLine& out, const std::string& serverName, const std::string& command) {
+    out << ":" << serverName << ERR_NEEDMOREPARAMS << command << " :Not enough parameters";
+}
+
 std::string IrcMessageFormatter::needMoreParams(const std::string& serverName, const std::string& command) {
-    return formatMessage(":" + serverName + ERR_NEEDMOREPARAMS + command + " :Not enough parameters");
+    IrcLine line;
+    needMoreParams(line, serverName, command);
+    return line.str();
+}
+
+void IrcMessageFormatter::genericError(IrcLine& out, const std::string& serverName, const std::string& errorCode, const std::string& details) {
+    out << ":" << serverName << " " << errorCode << " " << details;
 }
 
 std::string IrcMessageFormatter::genericError(const std::string& serverName, const std::string& errorCode, const std::string& details) {
-    return formatMessage(":" + serverName + " " + errorCode + " " + details);
+    IrcLine line;
+    genericError(line, serverName, errorCode, details);
+    return line.str();
 }
 
 // Erreurs de canal
+void IrcMessageFormatter::noSuchChannel(IrcLine& out, const std::string& serverName, const std::string& requester, const std::string& channelName) {
+    out << ":" << serverName << ERR_NOSUCHCHANNEL << requester << " " << channelName << " :No such channel";
+}
+
 std::string IrcMessageFormatter::noSuchChannel(const std::string& serverName, const std::string& requester, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_NOSUCHCHANNEL + requester + " " + channelName + " :No such channel");
+    IrcLine line;
+    noSuchChannel(line, serverName, requester, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::channelOperatorRequired(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName) {
+    out << ":" << serverName << ERR_CHANOPRIVSNEEDED << nickname << " " << channelName
+        << " :You're not channel operator";
 }
 
 std::string IrcMessageFormatter::channelOperatorRequired(const std::string& serverName, const std::string& nickname, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_CHANOPRIVSNEEDED + nickname + " " + channelName + " :You're not channel operator");
+    IrcLine line;
+    channelOperatorRequired(line, serverName, nickname, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::userNotInChannel(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName) {
+    out << ":" << serverName << ERR_USERNOTINCHANNEL << nickname << " " << channelName
+        << " :They aren't on that channel";
 }
 
 std::string IrcMessageFormatter::userNotInChannel(const std::string& serverName, const std::string& nickname, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_USERNOTINCHANNEL + nickname + " " + channelName + " :They aren't on that channel");
+    IrcLine line;
+    userNotInChannel(line, serverName, nickname, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::unknownMode(IrcLine& out, const std::string& serverName, const std::string& nickname, char modeChar) {
+    out << ":" << serverName << ERR_UNKNOWNMODE << nickname << " " << modeChar
+        << " :is unknown mode char to me";
 }
 
 std::string IrcMessageFormatter::unknownMode(const std::string& serverName, const std::string& nickname, char modeChar) {
-    return formatMessage(":" + serverName + ERR_UNKNOWNMODE + nickname + " " + modeChar + " :is unknown mode char to me");
+    IrcLine line;
+    unknownMode(line, serverName, nickname, modeChar);
+    return line.str();
+}
+
+void IrcMessageFormatter::notOnChannel(IrcLine& out, const std::string& serverName, const std::string& channelName) {
+    out << ":" << serverName << ERR_NOTONCHANNEL << channelName << " :You're not on that channel";
 }
 
 std::string IrcMessageFormatter::notOnChannel(const std::string& serverName, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_NOTONCHANNEL + channelName + " :You're not on that channel");
+    IrcLine line;
+    notOnChannel(line, serverName, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::noSuchNick(IrcLine& out, const std::string& serverName, const::std::string& requester, const std::string& targetNick) {
+    out << ":" << serverName << ERR_NOSUCHNICK << requester << " " << targetNick << " :No such nick/channel";
 }
 
 std::string IrcMessageFormatter::noSuchNick(const std::string& serverName, const::std::string& requester, const std::string& targetNick) {
-    return formatMessage(":" + serverName + ERR_NOSUCHNICK + requester + " " + targetNick + " :No such nick/channel");
+    IrcLine line;
+    noSuchNick(line, serverName, requester, targetNick);
+    return line.str();
+}
+
+void IrcMessageFormatter::userAlreadyOnChannel(IrcLine& out, const std::string& serverName, const std::string& targetNick, const std::string& channelName) {
+    out << ":" << serverName << ERR_USERONCHANNEL << targetNick << " " << channelName
+        << " :is already on channel";
 }
 
 std::string IrcMessageFormatter::userAlreadyOnChannel(const std::string& serverName, const std::string& targetNick, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_USERONCHANNEL + targetNick + " " + channelName + " :is already on channel");
+    IrcLine line;
+    userAlreadyOnChannel(line, serverName, targetNick, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::badChannelMask(IrcLine& out, const std::string& serverName, const std::string& channelName) {
+    out << ":" << serverName << ERR_BADCHANMASK << channelName << " :Bad Channel Mask";
 }
 
 std::string IrcMessageFormatter::badChannelMask(const std::string& serverName, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_BADCHANMASK + channelName + " :Bad Channel Mask");
+    IrcLine line;
+    badChannelMask(line, serverName, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::inviteOnlyChannel(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& channelName) {
+    out << ":" << serverName << ERR_INVITEONLYCHAN << nick << " " << channelName
+        << " :Cannot join channel (+i)";
 }
 
 std::string IrcMessageFormatter::inviteOnlyChannel(const std::string& serverName, const std::string& nick, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_INVITEONLYCHAN + nick + " " + channelName + " :Cannot join channel (+i)");
+    IrcLine line;
+    inviteOnlyChannel(line, serverName, nick, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::badChannelKey(IrcLine& out, const std::string& serverName, const std::string& channelName) {
+    out << ":" << serverName << ERR_BADCHANNELKEY << channelName << " :Cannot join channel (+k)";
 }
 
 std::string IrcMessageFormatter::badChannelKey(const std::string& serverName, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_BADCHANNELKEY + channelName + " :Cannot join channel (+k)");
+    IrcLine line;
+    badChannelKey(line, serverName, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::channelIsFull(IrcLine& out, const std::string& serverName, const std::string& channelName) {
+    out << ":" << serverName << ERR_CHANNELISFULL << channelName << " :Cannot join channel (+l)";
 }
 
 std::string IrcMessageFormatter::channelIsFull(const std::string& serverName, const std::string& channelName) {
-    return formatMessage(":" + serverName + ERR_CHANNELISFULL + channelName + " :Cannot join channel (+l)");
+    IrcLine line;
+    channelIsFull(line, serverName, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::cannotSendToChannel(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& target) {
+    out << ":" << serverName << ERR_CANNOTSENDTOCHAN << nickname << " " << target
+        << " :Cannot send to channel";
 }
 
 std::string IrcMessageFormatter::cannotSendToChannel(const std::string& serverName, const std::string& nickname, const std::string& target) {
-    return formatMessage(":" + serverName + ERR_CANNOTSENDTOCHAN + nickname + " " + target + " :Cannot send to channel");
+    IrcLine line;
+    cannotSendToChannel(line, serverName, nickname, target);
+    return line.str();
+}
+
+void IrcMessageFormatter::modeChanged(IrcLine& out, const std::string& serverName, const std::string& channelName, const std::string& modeString) {
+    out << ":" << serverName << RPL_CHANNELMODEIS << channelName << " " << modeString;
 }
 
 std::string IrcMessageFormatter::modeChanged(const std::string& serverName, const std::string& channelName, const std::string& modeString) {
-    return formatMessage(":" + serverName + RPL_CHANNELMODEIS + channelName + " " + modeString);
+    IrcLine line;
+    modeChanged(line, serverName, channelName, modeString);
+    return line.str();
 }
 
 // Erreurs de commandes
+void IrcMessageFormatter::invalidCapSubcommand(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& subCommand) {
+    out << ":" << serverName << ERR_INVALIDCAPCMD << nick << " " << subCommand << " :Invalid CAP subcommand";
+}
+
 std::string IrcMessageFormatter::invalidCapSubcommand(const std::string& serverName, const std::string& nick, const std::string& subCommand) {
-    return formatMessage(":" + serverName + ERR_INVALIDCAPCMD + nick + " " + subCommand + " :Invalid CAP subcommand");
+    IrcLine line;
+    invalidCapSubcommand(line, serverName, nick, subCommand);
+    return line.str();
+}
+
+void IrcMessageFormatter::notRegistered(IrcLine& out, const std::string& serverName) {
+    out << ":" << serverName << ERR_NOTREGISTERED << ":You have not registered";
 }
 
 std::string IrcMessageFormatter::notRegistered(const std::string& serverName) {
-    return formatMessage(":" + serverName + ERR_NOTREGISTERED + ":You have not registered");
+    IrcLine line;
+    notRegistered(line, serverName);
+    return line.str();
+}
+
+void IrcMessageFormatter::unknownCommand(IrcLine& out, const std::string& serverName, const std::string& command) {
+    out << ":" << serverName << ERR_UNKNOWNCOMMAND << command << " :Unknown command";
 }
 
 std::string IrcMessageFormatter::unknownCommand(const std::string& serverName, const std::string& command) {
-    return formatMessage(":" + serverName + ERR_UNKNOWNCOMMAND + command + " :Unknown command");
+    IrcLine line;
+    unknownCommand(line, serverName, command);
+    return line.str();
+}
+
+void IrcMessageFormatter::alreadyRegistered(IrcLine& out, const std::string& serverName) {
+    out << ":" << serverName << ERR_ALREADYREGISTRED << ":You may not reregister";
 }
 
 std::string IrcMessageFormatter::alreadyRegistered(const std::string& serverName) {
-    return formatMessage(":" + serverName + ERR_ALREADYREGISTRED + ":You may not reregister");
+    IrcLine line;
+    alreadyRegistered(line, serverName);
+    return line.str();
+}
+
+void IrcMessageFormatter::passwordMismatch(IrcLine& out, const std::string& serverName) {
+    out << ":" << serverName << ERR_PASSWDMISMATCH << ":Password incorrect";
 }
 
 std::string IrcMessageFormatter::passwordMismatch(const std::string& serverName) {
-    return formatMessage(":" + serverName + ERR_PASSWDMISMATCH + ":Password incorrect");
+    IrcLine line;
+    passwordMismatch(line, serverName);
+    return line.str();
 }
 
 // Erreurs de nickname
+void IrcMessageFormatter::noNicknameGiven(IrcLine& out, const std::string& serverName) {
+    out << ":" << serverName << ERR_NONICKNAMEGIVEN << ":No nickname given";
+}
+
 std::string IrcMessageFormatter::noNicknameGiven(const std::string& serverName) {
-    return formatMessage(":" + serverName + ERR_NONICKNAMEGIVEN + ":No nickname given");
+    IrcLine line;
+    noNicknameGiven(line, serverName);
+    return line.str();
+}
+
+void IrcMessageFormatter::erroneousNickname(IrcLine& out, const std::string& serverName, const std::string& newNickname) {
+    out << ":" << serverName << ERR_ERRONEUSNICKNAME << newNickname << " :Erroneous nickname";
 }
 
 std::string IrcMessageFormatter::erroneousNickname(const std::string& serverName, const std::string& newNickname) {
-    return formatMessage(":" + serverName + ERR_ERRONEUSNICKNAME + newNickname + " :Erroneous nickname");
+    IrcLine line;
+    erroneousNickname(line, serverName, newNickname);
+    return line.str();
+}
+
+void IrcMessageFormatter::nicknameInUse(IrcLine& out, const std::string& serverName, const std::string& current, const std::string& newNickname) {
+    out << ":" << serverName << ERR_NICKNAMEINUSE << current << " " << newNickname
+        << " :Nickname is already in use";
 }
 
 std::string IrcMessageFormatter::nicknameInUse(const std::string& serverName, const std::string& current, const std::string& newNickname) {
-    return formatMessage(":" + serverName + ERR_NICKNAMEINUSE + current + " " + newNickname + " :Nickname is already in use");
+    IrcLine line;
+    nicknameInUse(line, serverName, current, newNickname);
+    return line.str();
+}
+
+void IrcMessageFormatter::erroneousUsername(IrcLine& out, const std::string& serverName, const std::string& username) {
+    out << ":" << serverName << ERR_ERRONEUSUSERNAME << username << " :Erroneous username";
 }
 
 std::string IrcMessageFormatter::erroneousUsername(const std::string& serverName, const std::string& username) {
-    return formatMessage(":" + serverName + ERR_ERRONEUSUSERNAME + username + " :Erroneous username");
+    IrcLine line;
+    erroneousUsername(line, serverName, username);
+    return line.str();
 }
 
 // Messages de bienvenue et d'information
+void IrcMessageFormatter::welcome(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& realName, const std::string& host) {
+    out << ":" << serverName << RPL_WELCOME << nickname << " :Welcome to the Internet Relay Network "
+        << "Your nickname is " << nickname << " but your name is " << realName << "@" << host;
+}
+
 std::string IrcMessageFormatter::welcome(const std::string& serverName, const std::string& nickname, const std::string& realName, const std::string& host) {
-    return formatMessage(":" + serverName + RPL_WELCOME + nickname 
-        + " :Welcome to the Internet Relay Network "
-        + "Your nickname is " + nickname + " but your name is " + realName + "@" + host);
+    IrcLine line;
+    welcome(line, serverName, nickname, realName, host);
+    return line.str();
+}
+
+void IrcMessageFormatter::yourHost(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& serverVersion) {
+    out << ":" << serverName << RPL_YOURHOST << nick << " :Your host is " << serverName
+        << ", running version " << serverVersion;
 }
 
 std::string IrcMessageFormatter::yourHost(const std::string& serverName, const std::string& nick, const std::string& serverVersion) {
-    return formatMessage(":" + serverName + RPL_YOURHOST + nick 
-        + " :Your host is " + serverName + ", running version " + serverVersion);
+    IrcLine line;
+    yourHost(line, serverName, nick, serverVersion);
+    return line.str();
+}
+
+void IrcMessageFormatter::serverCreated(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& creationDate) {
+    out << ":" << serverName << RPL_CREATED << nick << " :This server was created " << creationDate;
 }
 
 std::string IrcMessageFormatter::serverCreated(const std::string& serverName, const std::string& nick, const std::string& creationDate) {
-    return formatMessage(":" + serverName + RPL_CREATED + nick 
-        + " :This server was created " + creationDate);
+    IrcLine line;
+    serverCreated(line, serverName, nick, creationDate);
+    return line.str();
+}
+
+void IrcMessageFormatter::myInfo(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& version, 
+                                    const std::string& userModes, const std::string& channelModes) {
+    out << ":" << serverName << RPL_MYINFO << nick << " " << serverName << " "
+        << version << " " << userModes << " " << channelModes;
 }
 
 std::string IrcMessageFormatter::myInfo(const std::string& serverName, const std::string& nick, const std::string& version, 
                                     const std::string& userModes, const std::string& channelModes) {
-    return formatMessage(":" + serverName + RPL_MYINFO + nick + " " + serverName + " " + version 
-        + " " + userModes + " " + channelModes);
+    IrcLine line;
+    myInfo(line, serverName, nick, version, userModes, channelModes);
+    return line.str();
 }
 
 // Messages MOTD
+void IrcMessageFormatter::motdStart(IrcLine& out, const std::string& serverName, const std::string& nick) {
+    out << ":" << serverName << RPL_MOTDSTART << nick << " :- " << serverName << " Message of the Day -";
+}
+
 std::string IrcMessageFormatter::motdStart(const std::string& serverName, const std::string& nick) {
-    return formatMessage(":" + serverName + RPL_MOTDSTART + nick + " :- " + serverName + " Message of the Day -");
+    IrcLine line;
+    motdStart(line, serverName, nick);
+    return line.str();
+}
+
+void IrcMessageFormatter::motdLine(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& message) {
+    out << ":" << serverName << RPL_MOTD << nick << " :- " << message;
 }
 
 std::string IrcMessageFormatter::motdLine(const std::string& serverName, const std::string& nick, const std::string& message) {
-    return formatMessage(":" + serverName + RPL_MOTD + nick + " :- " + message);
+    IrcLine line;
+    motdLine(line, serverName, nick, message);
+    return line.str();
+}
+
+void IrcMessageFormatter::motdEnd(IrcLine& out, const std::string& serverName, const std::string& nick) {
+    out << ":" << serverName << RPL_ENDOFMOTD << nick << " :End of /MOTD command.";
 }
 
 std::string IrcMessageFormatter::motdEnd(const std::string& serverName, const std::string& nick) {
-    return formatMessage(":" + serverName + RPL_ENDOFMOTD + nick + " :End of /MOTD command.");
+    IrcLine line;
+    motdEnd(line, serverName, nick);
+    return line.str();
 }
 
 // Messages de canal
-std::string IrcMessageFormatter::join(const std::string& nickname, const std::string& realname, const std::string& serverIp, const std::string& channelName) {
-    return formatMessage(":" + nickname + "!" + realname + "@" + serverIp + " JOIN :" + channelName);
+void IrcMessageFormatter::join(IrcLine& out, const std::string& prefix, const std::string& channelName) {
+    out << ":" << prefix << " JOIN :" << channelName;
+}
+
+std::string IrcMessageFormatter::join(const std::string& prefix, const std::string& channelName) {
+    IrcLine line;
+    join(line, prefix, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::part(IrcLine& out, const std::string& prefix, const std::string& channelName) {
+    out << ":" << prefix << " PART " << channelName;
 }
 
-std::string IrcMessageFormatter::part(const std::string& nickname, const std::string& username, const std::string& serverIp, const std::string& channelName) {
-    return formatMessage(":" + nickname + "!" + username + "@" + serverIp + " PART " + channelName);
+std::string IrcMessageFormatter::part(const std::string& prefix, const std::string& channelName) {
+    IrcLine line;
+    part(line, prefix, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::modeChange(IrcLine& out, const std::string& nickname, const std::string& channelName, const std::string& modeString) {
+    out << ":" << nickname << " MODE " << channelName << " " << modeString;
 }
 
 std::string IrcMessageFormatter::modeChange(const std::string& nickname, const std::string& channelName, const std::string& modeString) {
-    return formatMessage(":" + nickname + " MODE " + channelName + " " + modeString);
+    IrcLine line;
+    modeChange(line, nickname, channelName, modeString);
+    return line.str();
 }
 
-std::string IrcMessageFormatter::channelModeIs(const std::string& serverName, const std::string& nickname, const std::string& channelName, 
+void IrcMessageFormatter::channelModeIs(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName, 
                                            const std::string& modes, const std::string& modeParams) {
-    std::string message = ":" + serverName + RPL_CHANNELMODEIS + nickname + " " + channelName + " " + modes;
+    out << ":" << serverName << RPL_CHANNELMODEIS << nickname << " " << channelName << " " << modes;
     if (!modeParams.empty()) {
-        message += " " + modeParams;
+        out << " " << modeParams;
     }
-    return formatMessage(message);
+}
+
+std::string IrcMessageFormatter::channelModeIs(const std::string& serverName, const std::string& nickname, const std::string& channelName, 
+                                           const std::string& modes, const std::string& modeParams) {
+    IrcLine line;
+    channelModeIs(line, serverName, nickname, channelName, modes, modeParams);
+    return line.str();
 }
 
 // Messages de topic
+void IrcMessageFormatter::topicReply(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName, const std::string& topic) {
+    out << ":" << serverName << RPL_TOPIC << nickname << " " << channelName << " :" << topic;
+}
+
 std::string IrcMessageFormatter::topicReply(const std::string& serverName, const std::string& nickname, const std::string& channelName, const std::string& topic) {
-    return formatMessage(":" + serverName + RPL_TOPIC + nickname + " " + channelName + " :" + topic);
+    IrcLine line;
+    topicReply(line, serverName, nickname, channelName, topic);
+    return line.str();
+}
+
+void IrcMessageFormatter::noTopicReply(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& channelName) {
+    out << ":" << serverName << RPL_NOTOPIC << nickname << " " << channelName << " :No topic is set";
 }
 
 std::string IrcMessageFormatter::noTopicReply(const std::string& serverName, const std::string& nickname, const std::string& channelName) {
-    return formatMessage(":" + serverName + RPL_NOTOPIC + nickname + " " + channelName + " :No topic is set");
+    IrcLine line;
+    noTopicReply(line, serverName, nickname, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::topicChange(IrcLine& out, const std::string& nickname, const std::string& channelName, const std::string& topic) {
+    out << ":" << nickname << " TOPIC " << channelName << " :" << topic;
 }
 
 std::string IrcMessageFormatter::topicChange(const std::string& nickname, const std::string& channelName, const std::string& topic) {
-    return formatMessage(":" + nickname + " TOPIC " + channelName + " :" + topic);
+    IrcLine line;
+    topicChange(line, nickname, channelName, topic);
+    return line.str();
 }
 
 // Messages d'invitation
@@ -188,23 +420,47 @@ std::string IrcMessageFormatter::topicChange(const std::string& nickname, const
 // std::string IrcMessageFormatter::inviting(const std::string& serverName, const std::string& nickname, const std::string& targetNick, const std::string& channelName) {
 //     return formatMessage(":" + serverName + RPL_INVITING + nickname + " " + targetNick + " :" + channelName);
 // }
+void IrcMessageFormatter::invite(IrcLine& out, const std::string& nickname, const std::string& targetNick, const std::string& channelName) {
+    out << ":" << nickname << " INVITE " << targetNick << " :" << channelName;
+}
+
 std::string IrcMessageFormatter::invite(const std::string& nickname, const std::string& targetNick, const std::string& channelName) {
-    return formatMessage(":" + nickname + " INVITE " + targetNick + " :" + channelName);
+    IrcLine line;
+    invite(line, nickname, targetNick, channelName);
+    return line.str();
+}
+
+void IrcMessageFormatter::inviting(IrcLine& out, const std::string& serverName, const std::string& nickname, const std::string& targetNick, const std::string& channelName) {
+    out << ":" << serverName << RPL_INVITING << nickname << " " << targetNick << " :" << channelName;
 }
 
 std::string IrcMessageFormatter::inviting(const std::string& serverName, const std::string& nickname, const std::string& targetNick, const std::string& channelName) {
-    return formatMessage(":" + serverName + RPL_INVITING + nickname + " " + targetNick + " :" + channelName);
+    IrcLine line;
+    inviting(line, serverName, nickname, targetNick, channelName);
+    return line.str();
 }
 
 
 
 // Messages de kick
+void IrcMessageFormatter::kick(IrcLine& out, const std::string& nickname, const std::string& channelName, const std::string& targetNick, const std::string& comment) {
+    out << ":" << nickname << " KICK " << channelName << " " << targetNick << " :" << comment;
+}
+
 std::string IrcMessageFormatter::kick(const std::string& nickname, const std::string& channelName, const std::string& targetNick, const std::string& comment) {
-    return formatMessage(":" + nickname + " KICK " + channelName + " " + targetNick + " :" + comment);
+    IrcLine line;
+    kick(line, nickname, channelName, targetNick, comment);
+    return line.str();
+}
+
+void IrcMessageFormatter::quit(IrcLine& out, const std::string& prefix, const std::string& message) {
+    out << ":" << prefix << " QUIT :" << message;
 }
 
-std::string IrcMessageFormatter::quit(const std::string& nickname, const std::string& username, const std::string& serverIp, const std::string& message) {
-    return formatMessage(":" + nickname + "!" + username + "@" + serverIp + " QUIT " + message);
+std::string IrcMessageFormatter::quit(const std::string& prefix, const std::string& message) {
+    IrcLine line;
+    quit(line, prefix, message);
+    return line.str();
 }
 
 // Messages de nick
@@ -212,29 +468,84 @@ std::string IrcMessageFormatter::quit(const std::string& nickname, const std::st
   //  return formatMessage(":" + currentNickname + " NICK :" + newNickname);
 //}
 
-std::string IrcMessageFormatter::nickChange(const std::string& currentNickname, const std::string& username, const std::string& serverIp, const std::string& newNickname) {
-    return formatMessage(":" + currentNickname + "!" + username + "@" + serverIp +  " NICK :" + newNickname);
+void IrcMessageFormatter::nickChange(IrcLine& out, const std::string& oldPrefix, const std::string& newNickname) {
+    out << ":" << oldPrefix << " NICK :" << newNickname;
+}
+
+std::string IrcMessageFormatter::nickChange(const std::string& oldPrefix, const std::string& newNickname) {
+    IrcLine line;
+    nickChange(line, oldPrefix, newNickname);
+    return line.str();
 }
 
 // Messages de noms
+void IrcMessageFormatter::namesReply(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& channelName, const std::string& nickList) {
+    out << ":" << serverName << RPL_NAMREPLY << nick << " = " << channelName << " :" << nickList;
+}
+
 std::string IrcMessageFormatter::namesReply(const std::string& serverName, const std::string& nick, const std::string& channelName, const std::string& nickList) {
-    return formatMessage(":" + serverName + RPL_NAMREPLY + nick + " = " + channelName + " :" + nickList);
+    IrcLine line;
+    namesReply(line, serverName, nick, channelName, nickList);
+    return line.str();
+}
+
+void IrcMessageFormatter::endOfNames(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& channelName) {
+    out << ":" << serverName << RPL_ENDOFNAMES << nick << " " << channelName << " :End of /NAMES list.";
 }
 
 std::string IrcMessageFormatter::endOfNames(const std::string& serverName, const std::string& nick, const std::string& channelName) {
-    return formatMessage(":" + serverName + RPL_ENDOFNAMES + nick + " " + channelName + " :End of /NAMES list.");
+    IrcLine line;
+    endOfNames(line, serverName, nick, channelName);
+    return line.str();
 }
 
 // Messages de capacités
+void IrcMessageFormatter::capabilityList(IrcLine& out, const std::string& serverName, const std::string& nick, const std::string& capabilities) {
+    out << ":" << serverName << " CAP " << nick << " LS :" << capabilities;
+}
+
 std::string IrcMessageFormatter::capabilityList(const std::string& serverName, const std::string& nick, const std::string& capabilities) {
-    return formatMessage(":" + serverName + " CAP " + nick + " LS :" + capabilities);
+    IrcLine line;
+    capabilityList(line, serverName, nick, capabilities);
+    return line.str();
+}
+
+void IrcMessageFormatter::sendMsg(IrcLine& out, const std::string& sender, const std::string& target, const std::string& message) {
+    out << ":" << sender << " PRIVMSG " << target << " :" << message;
 }
 
-std::string IrcMessageFormatter::sendMsg(const std::string& sender, const std::string& target, const std::string& message){
-    return formatMessage(":" + sender + " PRIVMSG " + target + " :" + message);
+std::string IrcMessageFormatter::sendMsg(const std::string& sender, const std::string& target, const std::string& message) {
+    IrcLine line;
+    sendMsg(line, sender, target, message);
+    return line.str();
+}
+
+void IrcMessageFormatter::closingLink(IrcLine& out, const std::string& host, const std::string& reason) {
+    out << "ERROR :Closing Link: " << host << " (" << reason << ")";
+}
+
+std::string IrcMessageFormatter::closingLink(const std::string& host, const std::string& reason) {
+    IrcLine line;
+    closingLink(line, host, reason);
+    return line.str();
+}
+
+void IrcMessageFormatter::ping(IrcLine& out, const std::string& serverName) {
+    out << "PING :" << serverName;
+}
+
+std::string IrcMessageFormatter::ping(const std::string& serverName) {
+    IrcLine line;
+    ping(line, serverName);
+    return line.str();
+}
 
+void IrcMessageFormatter::pong(IrcLine& out, const std::string& message) {
+    out << "PONG :" << message;
 }
 
-std::string IrcMessageFormatter::pong(const std::string& message){
-    return formatMessage("PONG :" + message);
+std::string IrcMessageFormatter::pong(const std::string& message) {
+    IrcLine line;
+    pong(line, message);
+    return line.str();
 }
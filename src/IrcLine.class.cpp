@@ -0,0 +1,97 @@
+#include "../include/IrcLine.class.hpp"
+#include <cstring>
+
+IrcLine::IrcLine() : _length(0), _truncated(false)
+{
+	_buffer[0] = '\r';
+	_buffer[1] = '\n';
+}
+
+
+IrcLine &IrcLine::append(const char *bytes, size_t length)
+{
+	size_t room = MAX_CONTENT - _length;
+	if (length > room)
+	{
+		length = room;
+		_truncated = true;
+	}
+	memcpy(_buffer + _length, bytes, length);
+	_length += length;
+	_buffer[_length] = '\r';
+	_buffer[_length + 1] = '\n';
+	return *this;
+}
+
+
+IrcLine &IrcLine::operator<<(const std::string &text)
+{
+	return append(text.data(), text.size());
+}
+
+
+IrcLine &IrcLine::operator<<(const char *text)
+{
+	return append(text, strlen(text));
+}
+
+
+IrcLine &IrcLine::operator<<(char c)
+{
+	return append(&c, 1);
+}
+
+
+IrcLine &IrcLine::operator<<(long number)
+{
+	char digits[24];
+	size_t pos = sizeof(digits);
+	unsigned long value = (number < 0) ? -static_cast<unsigned long>(number) : number;
+	do
+	{
+		digits[--pos] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+	if (number < 0)
+		digits[--pos] = '-';
+	return append(digits + pos, sizeof(digits) - pos);
+}
+
+
+const char *IrcLine::data() const
+{
+	return _buffer;
+}
+
+
+size_t IrcLine::size() const
+{
+	return _length + 2;
+}
+
+
+size_t IrcLine::contentSize() const
+{
+	return _length;
+}
+
+
+bool IrcLine::truncated() const
+{
+	return _truncated;
+}
+
+
+std::string IrcLine::str() const
+{
+	return std::string(_buffer, _length + 2);
+}
+
+
+void IrcLine::clear()
+{
+	_length = 0;
+	_truncated = false;
+	_buffer[0] = '\r';
+	_buffer[1] = '\n';
+}
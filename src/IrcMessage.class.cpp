@@ -0,0 +1,181 @@
+#include "../include/IrcMessage.class.hpp"
+#include <cstring>
+
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+/*                                 STRINGVIEW                                */
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+
+StringView::StringView() : _data(""), _size(0)
+{
+}
+
+
+StringView::StringView(const char *data, size_t size) : _data(data), _size(size)
+{
+}
+
+
+const char *StringView::data() const
+{
+	return _data;
+}
+
+
+size_t StringView::size() const
+{
+	return _size;
+}
+
+
+bool StringView::empty() const
+{
+	return _size == 0;
+}
+
+
+char StringView::operator[](size_t index) const
+{
+	return _data[index];
+}
+
+
+std::string StringView::str() const
+{
+	return std::string(_data, _size);
+}
+
+
+bool StringView::operator==(const char *other) const
+{
+	return strlen(other) == _size && memcmp(_data, other, _size) == 0;
+}
+
+
+bool StringView::operator==(const std::string &other) const
+{
+	return other.size() == _size && memcmp(_data, other.data(), _size) == 0;
+}
+
+
+bool StringView::operator!=(const char *other) const
+{
+	return !(*this == other);
+}
+
+
+bool StringView::operator!=(const std::string &other) const
+{
+	return !(*this == other);
+}
+
+
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+/*                                 IRCMESSAGE                                */
+/*   -'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-'-,-',-'   */
+
+IrcMessage::IrcMessage() : _paramCount(0), _hasTrailing(false)
+{
+}
+
+
+// Returns the position of the next space (or of the end) from pos
+static size_t tokenEnd(const char *line, size_t pos, size_t end)
+{
+	while (pos < end && line[pos] != ' ')
+		pos++;
+	return pos;
+}
+
+
+static size_t skipSpaces(const char *line, size_t pos, size_t end)
+{
+	while (pos < end && line[pos] == ' ')
+		pos++;
+	return pos;
+}
+
+
+bool IrcMessage::parse(const char *line, size_t length)
+{
+	_prefix = StringView();
+	_command = StringView();
+	_paramCount = 0;
+	_hasTrailing = false;
+
+	// The line terminator is not part of the message
+	while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n'))
+		length--;
+
+	size_t pos = skipSpaces(line, 0, length);
+
+	// IRCv3 message tags are not supported: skip them
+	if (pos < length && line[pos] == '@')
+		pos = skipSpaces(line, tokenEnd(line, pos, length), length);
+
+	if (pos < length && line[pos] == ':')
+	{
+		size_t end = tokenEnd(line, pos, length);
+		_prefix = StringView(line + pos + 1, end - pos - 1);
+		pos = skipSpaces(line, end, length);
+	}
+
+	size_t end = tokenEnd(line, pos, length);
+	if (end == pos)
+		return false;
+	_command = StringView(line + pos, end - pos);
+	pos = end;
+
+	while (_paramCount < MAX_PARAMS)
+	{
+		pos = skipSpaces(line, pos, length);
+		if (pos >= length)
+			break;
+		// The trailing param, and the 15th one, take the rest of the line
+		if (line[pos] == ':' || _paramCount == MAX_PARAMS - 1)
+		{
+			_hasTrailing = (line[pos] == ':');
+			if (_hasTrailing)
+				pos++;
+			_params[_paramCount++] = StringView(line + pos, length - pos);
+			break;
+		}
+		end = tokenEnd(line, pos, length);
+		_params[_paramCount++] = StringView(line + pos, end - pos);
+		pos = end;
+	}
+	return true;
+}
+
+
+const StringView &IrcMessage::prefix() const
+{
+	return _prefix;
+}
+
+
+const StringView &IrcMessage::command() const
+{
+	return _command;
+}
+
+
+const StringView &IrcMessage::param(size_t index) const
+{
+	static const StringView none;
+
+	if (index >= _paramCount)
+		return none;
+	return _params[index];
+}
+
+
+size_t IrcMessage::paramCount() const
+{
+	return _paramCount;
+}
+
+
+bool IrcMessage::hasTrailing() const
+{
+	return _hasTrailing;
+}
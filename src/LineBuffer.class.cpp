@@ -0,0 +1,95 @@
+#include "../include/LineBuffer.class.hpp"
+#include <cstring>
+
+LineBuffer::LineBuffer() : _start(0), _end(0), _scan(0), _discarding(false)
+{
+}
+
+
+char *LineBuffer::writePtr()
+{
+	return _data + _end;
+}
+
+
+size_t LineBuffer::writable() const
+{
+	return CAPACITY - _end;
+}
+
+
+void LineBuffer::commit(size_t bytes)
+{
+	_end += bytes;
+}
+
+
+bool LineBuffer::nextLine(const char *&line, size_t &length)
+{
+	while (true)
+	{
+		const char *newline = static_cast<const char *>(
+			memchr(_data + _scan, '\n', _end - _scan));
+		if (!newline)
+		{
+			_scan = _end;	// never scan these bytes again
+			return false;
+		}
+
+		line = _data + _start;
+		length = newline - line;
+		_start = newline - _data + 1;
+		_scan = _start;
+		if (_discarding)
+		{
+			_discarding = false;	// end of the overlong line, drop it
+			continue;
+		}
+		if (length > 0 && line[length - 1] == '\r')
+			length--;
+		return true;
+	}
+}
+
+
+void LineBuffer::unread(const char *line)
+{
+	_start = line - _data;
+	_scan = _start;
+}
+
+
+bool LineBuffer::hasLine() const
+{
+	return memchr(_data + _scan, '\n', _end - _scan) != NULL;
+}
+
+
+void LineBuffer::compact()
+{
+	if (_start == _end)
+	{
+		_start = _end = _scan = 0;
+		return;
+	}
+	if (_start > 0)
+	{
+		memmove(_data, _data + _start, _end - _start);
+		_end -= _start;
+		_scan -= _start;
+		_start = 0;
+	}
+	// A full buffer without any line in it: drop it until the next '\n'
+	if (_end == CAPACITY && !hasLine())
+	{
+		_start = _end = _scan = 0;
+		_discarding = true;
+	}
+}
+
+
+void LineBuffer::clear()
+{
+	_start = _end = _scan = 0;
+	_discarding = false;
+}
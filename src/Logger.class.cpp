@@ -0,0 +1,293 @@
+#include "../include/Logger.class.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <strings.h>
+#include <unistd.h>
+
+Logger::Level Logger::_level = Logger::INFO;
+unsigned int Logger::_categories = Logger::ALL_CATEGORIES;
+Logger::Slot *Logger::_ring = NULL;
+volatile size_t Logger::_enqueuePos = 0;
+size_t Logger::_dequeuePos = 0;
+volatile unsigned long Logger::_dropped = 0;
+bool Logger::_running = false;
+pthread_t Logger::_thread;
+bool Logger::_sleeping = false;
+pthread_mutex_t Logger::_wakeLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t Logger::_wakeCond = PTHREAD_COND_INITIALIZER;
+
+static const char *const levelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static const struct
+{
+	const char *name;
+	Logger::Category category;
+} categoryNames[] = {
+	{ "server", Logger::SERVER },
+	{ "net", Logger::NET },
+	{ "client", Logger::CLIENT },
+	{ "channel", Logger::CHANNEL },
+	{ "command", Logger::COMMAND }
+};
+static const size_t categoryCount = sizeof(categoryNames) / sizeof(categoryNames[0]);
+
+
+static const char *categoryName(Logger::Category category)
+{
+	for (size_t i = 0; i < categoryCount; ++i)
+	{
+		if (categoryNames[i].category == category)
+			return categoryNames[i].name;
+	}
+	return "?";
+}
+
+
+static void writeAll(int fd, const std::string &bytes)
+{
+	size_t done = 0;
+	while (done < bytes.size())
+	{
+		ssize_t written = ::write(fd, bytes.data() + done, bytes.size() - done);
+		if (written == -1 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return;
+		done += written;
+	}
+}
+
+
+/**
+ * @description Reads the level ("debug", "info", "warn", "error", "off") and
+ * a comma separated list of categories ("net,command" or "all").
+ * NULL keeps the defaults: info and above, every category.
+ * @return false if one of them is not recognised
+ */
+bool Logger::configure(const char *level, const char *categories)
+{
+	if (level && *level)
+	{
+		size_t i = 0;
+		while (i < OFF && strcasecmp(level, levelNames[i]) != 0)
+			++i;
+		if (i == OFF && strcasecmp(level, "off") != 0)
+			return false;
+		_level = static_cast<Level>(i);
+	}
+
+	if (categories && *categories)
+	{
+		unsigned int mask = 0;
+		std::string list(categories);
+		std::string::size_type begin = 0;
+		while (begin <= list.size())
+		{
+			std::string::size_type end = list.find(',', begin);
+			if (end == std::string::npos)
+				end = list.size();
+			std::string name = list.substr(begin, end - begin);
+			if (strcasecmp(name.c_str(), "all") == 0)
+				mask |= ALL_CATEGORIES;
+			else
+			{
+				size_t i = 0;
+				while (i < categoryCount && strcasecmp(name.c_str(), categoryNames[i].name) != 0)
+					++i;
+				if (i == categoryCount)
+					return false;
+				mask |= categoryNames[i].category;
+			}
+			begin = end + 1;
+		}
+		_categories = mask;
+	}
+	return true;
+}
+
+
+/**
+ * @description Allocates the ring and starts the drain thread. The thread
+ * blocks SIGINT/SIGQUIT so that they keep reaching the event loop.
+ */
+void Logger::start()
+{
+	if (running())
+		return;
+	_ring = new Slot[RING_SIZE];
+	for (size_t i = 0; i < RING_SIZE; ++i)
+		_ring[i].sequence = i;
+	_enqueuePos = 0;
+	_dequeuePos = 0;
+
+	sigset_t blocked, previous;
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGQUIT);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	__atomic_store_n(&_running, true, __ATOMIC_SEQ_CST);
+	if (pthread_create(&_thread, NULL, &Logger::drainLoop, NULL) != 0)
+	{
+		__atomic_store_n(&_running, false, __ATOMIC_SEQ_CST);
+		delete[] _ring;
+		_ring = NULL;
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+
+// Writes what is left in the ring; later lines are written synchronously
+void Logger::stop()
+{
+	if (!running())
+		return;
+	__atomic_store_n(&_running, false, __ATOMIC_SEQ_CST);
+	pthread_mutex_lock(&_wakeLock);
+	pthread_cond_signal(&_wakeCond);
+	pthread_mutex_unlock(&_wakeLock);
+	pthread_join(_thread, NULL);
+	drain();
+	delete[] _ring;
+	_ring = NULL;
+}
+
+
+/**
+ * @description Claims the next slot of the ring (multi-producer, lock-free)
+ * and copies the line into it. Before start() and after stop() the line is
+ * written directly.
+ */
+void Logger::write(Level level, Category category, const std::string &text)
+{
+	if (!running())
+	{
+		std::string line;
+		append(line, level, category, text.data(), text.size());
+		writeAll(level >= WARN ? STDERR_FILENO : STDOUT_FILENO, line);
+		return;
+	}
+
+	size_t pos = _enqueuePos;
+	Slot *slot;
+	while (true)
+	{
+		slot = &_ring[pos & (RING_SIZE - 1)];
+		long diff = static_cast<long>(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE)) - static_cast<long>(pos);
+		if (diff == 0)
+		{
+			if (__sync_bool_compare_and_swap(&_enqueuePos, pos, pos + 1))
+				break;
+			pos = _enqueuePos;
+		}
+		else if (diff < 0)
+		{
+			__sync_fetch_and_add(&_dropped, 1);	// full: never block the caller
+			return;
+		}
+		else
+			pos = _enqueuePos;
+	}
+
+	slot->level = level;
+	slot->category = category;
+	slot->length = (text.size() < LINE_SIZE) ? text.size() : LINE_SIZE;
+	memcpy(slot->text, text.data(), slot->length);
+	__atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);	// publish the slot to the drain thread
+
+	// Pairs with drainLoop(): either it sees the slot, or this sees it asleep
+	__sync_synchronize();
+	if (__atomic_load_n(&_sleeping, __ATOMIC_SEQ_CST))
+		wakeDrainThread();
+}
+
+
+void Logger::wakeDrainThread()
+{
+	pthread_mutex_lock(&_wakeLock);
+	pthread_cond_signal(&_wakeCond);
+	pthread_mutex_unlock(&_wakeLock);
+}
+
+
+unsigned long Logger::dropped()
+{
+	return _dropped;
+}
+
+
+bool Logger::running()
+{
+	return __atomic_load_n(&_running, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * @description Drains the ring, and sleeps while it is empty. The thread says
+ * it is going to sleep before it checks the ring one last time, so that a
+ * line published in between is either seen here or wakes it up.
+ */
+void *Logger::drainLoop(void *arg)
+{
+	(void)arg;
+	while (running())
+	{
+		if (drain() != 0)
+			continue;
+		pthread_mutex_lock(&_wakeLock);
+		__atomic_store_n(&_sleeping, true, __ATOMIC_SEQ_CST);
+		__sync_synchronize();
+		if (!hasPending() && running())
+			pthread_cond_wait(&_wakeCond, &_wakeLock);
+		__atomic_store_n(&_sleeping, false, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&_wakeLock);
+	}
+	return NULL;
+}
+
+
+// Drain thread only: whether the next slot has been published
+bool Logger::hasPending()
+{
+	return __atomic_load_n(&_ring[_dequeuePos & (RING_SIZE - 1)].sequence, __ATOMIC_ACQUIRE) == _dequeuePos + 1;
+}
+
+
+// Single consumer: gathers every published slot, then writes each stream once
+size_t Logger::drain()
+{
+	std::string out;
+	std::string err;
+	size_t count = 0;
+
+	while (true)
+	{
+		Slot &slot = _ring[_dequeuePos & (RING_SIZE - 1)];
+		if (__atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE) != _dequeuePos + 1)
+			break;
+		Level level = static_cast<Level>(slot.level);
+		append(level >= WARN ? err : out, level, static_cast<Category>(slot.category),
+			slot.text, slot.length);
+		// hand the slot back to the producers
+		__atomic_store_n(&slot.sequence, _dequeuePos + RING_SIZE, __ATOMIC_RELEASE);
+		_dequeuePos++;
+		count++;
+	}
+	if (!out.empty())
+		writeAll(STDOUT_FILENO, out);
+	if (!err.empty())
+		writeAll(STDERR_FILENO, err);
+	return count;
+}
+
+
+void Logger::append(std::string &out, Level level, Category category, const char *text, size_t length)
+{
+	out += '[';
+	out += levelNames[level];
+	out += "] [";
+	out += categoryName(category);
+	out += "] ";
+	out.append(text, length);
+	out += '\n';
+}
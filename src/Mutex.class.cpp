@@ -0,0 +1,36 @@
+#include "../include/Mutex.class.hpp"
+
+Mutex::Mutex()
+{
+	pthread_mutex_init(&_mutex, NULL);
+}
+
+
+Mutex::~Mutex()
+{
+	pthread_mutex_destroy(&_mutex);
+}
+
+
+void Mutex::lock()
+{
+	pthread_mutex_lock(&_mutex);
+}
+
+
+void Mutex::unlock()
+{
+	pthread_mutex_unlock(&_mutex);
+}
+
+
+ScopedLock::ScopedLock(Mutex &mutex) : _mutex(mutex)
+{
+	_mutex.lock();
+}
+
+
+ScopedLock::~ScopedLock()
+{
+	_mutex.unlock();
+}
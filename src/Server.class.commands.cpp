@@ -9,36 +9,28 @@
  * If the password is incorrect or not provided, the client is disconnected.
  * SYNTAX : PASS <password>
  */
-void	Server::handlePass(Client *client, std::vector<std::string> args)
+void	Server::handlePass(Client *client, const IrcMessage &msg)
 {
 	// Check if they already set their password, they can't do it twice
 	if (client->hasSentPassword())
 	{
 		std::string errorResponse = IrcMessageFormatter::alreadyRegistered(_serverName);
-		send(client->getSocket(), errorResponse.c_str(), errorResponse.size(), 0);
-		return ;
-	}
-	
-	// Make sure there is at least 2 arguments
-	if (args.size() < 2)
-	{
-		std::string errorResponse = IrcMessageFormatter::needMoreParams(_serverName, args[0]);
-		send(client->getSocket(), errorResponse.c_str(), errorResponse.size(), 0);
+		client->queueMessage(errorResponse);
 		return ;
 	}
 	
 	// Check the password is correct, otherwise disconnect the client
-	if (args[1] != _password)
+	if (msg.param(0) != _password)
 	{
 		std::string errorResponse = IrcMessageFormatter::passwordMismatch(_serverName);
-		send(client->getSocket(), errorResponse.c_str(), errorResponse.size(), 0);
-		disconnectClient(client->getSocket());
+		client->queueMessage(errorResponse);
+		disconnectClient(client);
 		return ;
 	}
 
 	// Update the status of this client
 	client->setSentPassword(true);
-	std::cout << "Client on socket <" << client->getSocket() << "> has authenticated password" << std::endl;
+	LOG_INFO(COMMAND, "Client on socket <" << client->getSocket() << "> has authenticated password");
 }
 
 /* NICK 
@@ -55,7 +47,7 @@ le flood par changement de nick.
 Syntaxe : /nick (nick) 
 Example : /nick MEPHISTO- */
 
-bool Server::nickIsValid(const std::string& newNick) const
+bool Server::nickIsValid(const std::string& newNick)
 {
 	std::string specialChars("[\\]^_{|}");
 
@@ -77,15 +69,8 @@ bool Server::nickIsValid(const std::string& newNick) const
 
 bool	Server::nickIsUnique(Client* requestingClient, const std::string& newNick) const
 {
-	std::vector<Client*>::const_iterator it;
-	for (it = _clients.begin(); it != _clients.end(); it++)
-	{
-		if (*it == requestingClient)
-			continue ;
-		if ((*it)->getNickname() == newNick)
-			return (false);
-	}
-	return (true);
+	Client *owner = getClientByNickname(newNick);
+	return (owner == NULL || owner == requestingClient);
 }
 
 
@@ -95,37 +80,40 @@ bool	Server::nickIsUnique(Client* requestingClient, const std::string& newNick)
  * If the client is already registered, it notifies other clients of the nickname change.
  * SYNTAX : NICK <nickname>
  */
-void	Server::handleNick(Client *client, std::vector<std::string> args)
+void	Server::handleNick(Client *client, const IrcMessage &msg)
 {
 	std::string response;
 
 	if (!client->hasSentPassword())
 	{
 		std::string response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		disconnectClient(client->getSocket());
+		client->queueMessage(response);
+		disconnectClient(client);
 		return ;
 	}
 
-	if (args.size() < 2)
+	std::string newNick = msg.param(0).str();
+	if (msg.paramCount() < 1)
 		response = IrcMessageFormatter::noNicknameGiven(_serverName);
-	else if (nickIsValid(args[1]) == false)
-		response = IrcMessageFormatter::erroneousNickname(_serverName, args[1]);
-	else if (nickIsUnique(client, args[1]) == false)
-		response = IrcMessageFormatter::nicknameInUse(_serverName, client->getNickname(), args[1]);
+	else if (nickIsValid(newNick) == false)
+		response = IrcMessageFormatter::erroneousNickname(_serverName, newNick);
+	else if (nickIsUnique(client, newNick) == false)
+		response = IrcMessageFormatter::nicknameInUse(_serverName, client->getNickname(), newNick);
 	else
 	{
-		std::string currentNick = client->getNickname();
-		client->setNickname(args[1]);
+		std::string oldPrefix = client->getPrefix();
+		renameClient(client, newNick);
 		client->setSentNickname(true);
-		std::cout << "Client on socket <" << client->getSocket() << "> has set nick name : " << args[1] << std::endl;
+		LOG_INFO(COMMAND, "Client on socket <" << client->getSocket() << "> has set nick name : " << newNick);
 
 		if (client->isRegistered())
 		{
-			response = IrcMessageFormatter::nickChange(currentNick, client->getUsername(), client->getIp(), args[1]);
-			std::vector<Channel*>chans = client->getChannelsList();
-			for (std::vector<Channel*>::iterator it = chans.begin(); it != chans.end(); it++)
-				(*it)->broadcast(response);
+			IrcLine line;
+			IrcMessageFormatter::nickChange(line, oldPrefix, newNick);
+			SharedMessage nickMsg(line);
+			const Client::ChannelSet &chans = client->getChannelsList();
+			for (Client::ChannelSet::const_iterator it = chans.begin(); it != chans.end(); it++)
+				(*it)->broadcast(nickMsg);
 		}
 		else if (client->readyToRegister())
 			registerClient(client);
@@ -138,50 +126,33 @@ void	Server::handleNick(Client *client, std::vector<std::string> args)
  * If the client is ready to register, it calls the registerClient function.
  * SYNTAX : USER <username> <hostname> <servername> :<realname>
  */
-void	Server::handleUser(Client *client, std::vector<std::string> args)
+void	Server::handleUser(Client *client, const IrcMessage &msg)
 {
 	std::string response;
 
 	if (!client->hasSentPassword())
 	{
 		std::string response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		disconnectClient(client->getSocket());
+		client->queueMessage(response);
+		disconnectClient(client);
 		return ;
 	}
 
 	if (client->hasSentUsername() == true)
 	{
 		response = IrcMessageFormatter::alreadyRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return ;
 
 	}
 	
-	if (args.size() < 5)
-	{
-		response = IrcMessageFormatter::needMoreParams(_serverName, args[0]);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-
-	if (args[4][0] != ':')
-	{
-		response = IrcMessageFormatter::erroneousUsername(_serverName, args[4]);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-	
 	// Set the client fieds
-	client->setUsername(args[1]);
-	client->setHostname(args[2]);
-	client->setServername(args[3]);
-
-	std::string realName = args[4];
-	realName.erase(0, 1);
-	client->setRealname(realName);
+	client->setUsername(msg.param(0).str());
+	client->setHostname(msg.param(1).str());
+	client->setServername(msg.param(2).str());
+	client->setRealname(msg.param(3).str());
 	client->setSentUsername(true);
-	std::cout << "Client <" << client->getSocket() << "> has set their user." << std::endl;
+	LOG_INFO(COMMAND, "Client <" << client->getSocket() << "> has set their user.");
 	if (client->readyToRegister())
 		registerClient(client);
 	
@@ -193,70 +164,51 @@ void	Server::handleUser(Client *client, std::vector<std::string> args)
  * It checks if the client has the necessary permissions to kick another client and sends appropriate responses.
  * SYNTAX : KICK <channel> <nickname> [<comment>]
  */
-void	Server::handleKick(Client *client, std::vector<std::string> args)
+void	Server::handleKick(Client *client, const IrcMessage &msg)
 {
 	std::string response;
 
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-
-	if (args.size() < 3) {
-		response = IrcMessageFormatter::needMoreParams(_serverName, "KICK");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}		
-	std::string channelName = args[1];
+	std::string channelName = msg.param(0).str();
 	Channel *channel = this->getChannel(channelName);
 	if (channel == NULL) {
 		response = IrcMessageFormatter::noSuchChannel(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (!client->isInChannel(channelName)) {
+	if (!client->isInChannel(channel)) {
 		response = IrcMessageFormatter::notOnChannel(_serverName, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 	if (!channel->isOperator(client)) {
 		response = IrcMessageFormatter::channelOperatorRequired(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	std::string targetNick = args[2];
-	Client *targetClient = NULL;
-	for (std::vector<Client *>::const_iterator it = channel->getClients().begin(); it != channel->getClients().end(); ++it)
-	{
-		if ((*it)->getNickname() == targetNick) {
-			targetClient = *it;
-			break;
-		}
-	}
-	if (targetClient == NULL) {
+	std::string targetNick = msg.param(1).str();
+	Client *targetClient = getClientByNickname(targetNick);
+	if (targetClient == NULL || !channel->hasClient(targetClient)) {
 		response = IrcMessageFormatter::noSuchNick(_serverName, client->getNickname(), targetNick);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 	if (!channel->isOperator(client)) {
 		response = IrcMessageFormatter::channelOperatorRequired(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 	std::string reason;
-	if (args.size() == 4)
-		reason = args[3];
+	if (msg.paramCount() == 3)
+		reason = msg.param(2).str();
 	else
 		reason = "";
 
-	response = IrcMessageFormatter::kick(client->getNickname(), channelName, targetNick, reason);
+	response = IrcMessageFormatter::kick(client->getPrefix(), channelName, targetNick, reason);
 	channel->broadcast(response);
 	channel->removeClient(targetClient);
 	targetClient->leaveChannel(channel);
 	channel->removeInvitation(targetClient);
-	std::cout << targetClient->getNickname() << " has been kicked from channel <" << channelName << ">" << std::endl;
+	LOG_INFO(COMMAND, targetClient->getNickname() << " has been kicked from channel <" << channelName << ">");
 
 }
 
@@ -267,58 +219,38 @@ void	Server::handleKick(Client *client, std::vector<std::string> args)
  * It checks if the client has the necessary permissions to invite another client and sends appropriate responses.
  * SYNTAX : INVITE <nickname> <channel>
  */
-void	Server::handleInvite(Client *client, std::vector<std::string> args)
+void	Server::handleInvite(Client *client, const IrcMessage &msg)
 {
 	std::string response;
 
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-
-	if (args.size() < 3) {
-		response = IrcMessageFormatter::needMoreParams(_serverName, "INVITE");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}	
-
-	std::string targetNick = args[1];
-	std::string channelName = args[2];
+	std::string targetNick = msg.param(0).str();
+	std::string channelName = msg.param(1).str();
 
 	Channel *channel = this->getChannel(channelName);
 	if (channel == NULL) {
 		response = IrcMessageFormatter::noSuchChannel(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (!client->isInChannel(channelName)) {
+	if (!client->isInChannel(channel)) {
 		response = IrcMessageFormatter::notOnChannel(_serverName, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (channel->hasMode('i') && !channel->isOperator(client)) {
+	if (channel->hasMode(Channel::MODE_INVITE_ONLY) && !channel->isOperator(client)) {
 		response = IrcMessageFormatter::channelOperatorRequired(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	Client *targetClient = NULL;
-	for (std::vector<Client *>::const_iterator it = _clients.begin(); it != _clients.end(); ++it)
-	{
-		if ((*it)->getNickname() == targetNick) {
-			targetClient = *it;
-			break;
-		}
-	}
+	Client *targetClient = getClientByNickname(targetNick);
 	if (targetClient == NULL) {
 		response = IrcMessageFormatter::noSuchNick(_serverName, client->getNickname(), targetNick);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (targetClient->isInChannel(channelName)) {
+	if (targetClient->isInChannel(channel)) {
 		response = IrcMessageFormatter::userAlreadyOnChannel(_serverName, targetNick, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 
@@ -328,8 +260,8 @@ void	Server::handleInvite(Client *client, std::vector<std::string> args)
     channel->broadcast(response);
 
 	// Inform client that they are invited
-    response = IrcMessageFormatter::invite(client->getNickname(), targetNick, channelName);
-    send(targetClient->getSocket(), response.c_str(), response.size(), 0);
+    response = IrcMessageFormatter::invite(client->getPrefix(), targetNick, channelName);
+    targetClient->queueMessage(response);
 
 }
 
@@ -339,74 +271,46 @@ void	Server::handleInvite(Client *client, std::vector<std::string> args)
  * It checks if the client has the necessary permissions to change the topic and sends appropriate responses.
  * SYNTAX : TOPIC <channel> [<topic>]
  */
-void	Server::handleTopic(Client *client, std::vector<std::string> args)
+void	Server::handleTopic(Client *client, const IrcMessage &msg)
 {
 	std::string response;
 
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-
-	if (args.size() < 2) {
-		response = IrcMessageFormatter::needMoreParams(_serverName, "TOPIC");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}	
-
-	std::string channelName = args[1];
+	std::string channelName = msg.param(0).str();
 	Channel *channel = this->getChannel(channelName);
 	if (channel == NULL) {
 		response = IrcMessageFormatter::noSuchChannel(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (!client->isInChannel(channelName)) {
+	if (!client->isInChannel(channel)) {
 		response = IrcMessageFormatter::notOnChannel(_serverName, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (args.size() == 2) {
+	if (msg.paramCount() == 1) {
 		// Retrieve the topic of the channel
 		 if (!channel->hasTopic() || channel->getTopic().empty()) {
             response = IrcMessageFormatter::noTopicReply(_serverName, client->getNickname(), channelName);
-            send(client->getSocket(), response.c_str(), response.size(), 0);
+            client->queueMessage(response);
         } else {
             response = IrcMessageFormatter::topicReply(_serverName, client->getNickname(), channelName, channel->getTopic());
-            send(client->getSocket(), response.c_str(), response.size(), 0);
+            client->queueMessage(response);
         }
         return;
 	}
-	if (channel->hasMode('t') && !channel->isOperator(client)) {
+	if (channel->hasMode(Channel::MODE_TOPIC_LOCK) && !channel->isOperator(client)) {
         response = IrcMessageFormatter::channelOperatorRequired(_serverName, client->getNickname(), channelName);
-        send(client->getSocket(), response.c_str(), response.size(), 0);
+        client->queueMessage(response);
         return;
     }
     
-    // Reconstruct the topic from remaining arguments (handling spaces)
-    std::string topic;
-    for (size_t i = 2; i < args.size(); ++i) {
-        if (i > 2) topic += " ";
-        topic += args[i];
-    }
-    
-    // Remove leading ':' if present
-    if (!topic.empty() && topic[0] == ':') {
-        topic = topic.substr(1);
-    }
-    
+    std::string topic = msg.param(1).str();
     channel->setTopic(topic);
     
     // Notify all clients in the channel about the new topic
-    for (std::vector<Client *>::const_iterator it = channel->getClients().begin(); it != channel->getClients().end(); ++it)
-    {
-        std::string notifyResponse = IrcMessageFormatter::topicChange(client->getNickname(), channelName, topic);
-        send((*it)->getSocket(), notifyResponse.c_str(), notifyResponse.size(), 0);
-    }
+    channel->broadcast(IrcMessageFormatter::topicChange(client->getPrefix(), channelName, topic));
     
-    std::cout << "Topic for channel <" << channelName << "> changed to: " << topic << std::endl;
+    LOG_INFO(COMMAND, "Topic for channel <" << channelName << "> changed to: " << topic);
 }
 
 
@@ -415,51 +319,47 @@ void	Server::handleTopic(Client *client, std::vector<std::string> args)
  * It checks if the client has the necessary permissions to change the modes and sends appropriate responses.
  * SYNTAX : MODE <channel> <mode> [<parameters>]
  */
-void	Server::handleMode(Client *client, std::vector<std::string> args)
+void	Server::handleMode(Client *client, const IrcMessage &msg)
 {
-	std::cout << "Entered Handle Mode function" << std::endl;
+	LOG_DEBUG(COMMAND, "Entered Handle Mode function");
 	std::string response;
 
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-
-	if (args.size() < 3) {
-		response = IrcMessageFormatter::needMoreParams(_serverName, "MODE");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}	
-
-	std::string channelName = args[1];
+	std::string channelName = msg.param(0).str();
 	Channel *channel = this->getChannel(channelName);
-	std::cout << "Channel name: " << channelName << std::endl;
+	LOG_DEBUG(COMMAND, "Channel name: " << channelName);
 	if (channel == NULL) {
 		response = IrcMessageFormatter::noSuchChannel(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	std::cout << "Client is in channel: " << client->isInChannel(channelName) << std::endl;
-	if (!client->isInChannel(channelName)) {
+	LOG_DEBUG(COMMAND, "Client is in channel: " << client->isInChannel(channel));
+	if (!client->isInChannel(channel)) {
 		response = IrcMessageFormatter::notOnChannel(_serverName, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
+		return;
+	}
+
+	// MODE #channel without a modestring queries the current modes
+	if (msg.paramCount() < 2) {
+		IrcLine line;
+		IrcMessageFormatter::channelModeIs(line, _serverName, client->getNickname(), channelName,
+			channel->getModeString(), channel->getModeParams());
+		client->queueMessage(line);
 		return;
 	}
 
     if (!channel->isOperator(client)) {
-		std::cout << "Checkpoint 1" << std::endl;
+		LOG_DEBUG(COMMAND, "Checkpoint 1");
         response = IrcMessageFormatter::channelOperatorRequired(_serverName, client->getNickname(), channelName);
-        send(client->getSocket(), response.c_str(), response.size(), 0);
+        client->queueMessage(response);
         return;
     }
 
-	std::string modeString = args[2];
+	std::string modeString = msg.param(1).str();
 	if (modeString.empty()) {
-		std::cout << "Checkpoint 2" << std::endl;
+		LOG_DEBUG(COMMAND, "Checkpoint 2");
 		response = IrcMessageFormatter::needMoreParams(_serverName, "MODE");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 	bool adding = true;
@@ -479,104 +379,89 @@ void	Server::handleMode(Client *client, std::vector<std::string> args)
 		else if (modeChar == 'i' || modeChar == 't') {
 			// Simple modes without parameters
 			if (adding) {
-				channel->setMode(modeChar);
+				channel->setMode(Channel::modeBit(modeChar));
 				processedModes += modeChar;
-				std::cout << "Mode +" << modeChar << " added to channel <" << channelName << ">" << std::endl;
+				LOG_DEBUG(COMMAND, "Mode +" << modeChar << " added to channel <" << channelName << ">");
 			} else {
-				channel->unsetMode(modeChar);
+				channel->unsetMode(Channel::modeBit(modeChar));
 				processedModes += modeChar;
-				std::cout << "Mode -" << modeChar << " removed from channel <" << channelName << ">" << std::endl;
+				LOG_DEBUG(COMMAND, "Mode -" << modeChar << " removed from channel <" << channelName << ">");
 			}
 		} else if (modeChar == 'k') {
 			// Key mode requires parameter
 			if (adding) {
-				if (args.size() > 3) {
-					channel->setKey(args[3]);
-					channel->setMode('k');
+				if (msg.paramCount() > 2) {
+					channel->setKey(msg.param(2).str());
 					processedModes += modeChar;
-					std::cout << "Key set for channel <" << channelName << ">" << std::endl;
+					LOG_DEBUG(COMMAND, "Key set for channel <" << channelName << ">");
 				} else {
 					response = IrcMessageFormatter::needMoreParams(_serverName, "MODE");
-					send(client->getSocket(), response.c_str(), response.size(), 0);
+					client->queueMessage(response);
 					return;
 				}
 			} else {
 				channel->unsetKey();
 				processedModes += modeChar;
-				std::cout << "Key removed from channel <" << channelName << ">" << std::endl;
+				LOG_DEBUG(COMMAND, "Key removed from channel <" << channelName << ">");
 			}
 		} else if (modeChar == 'l') {
 			// Limit mode
 			if (adding) {
-				if (args.size() > 3) {
-					int limit = std::atoi(args[3].c_str());
+				if (msg.paramCount() > 2) {
+					int limit = std::atoi(msg.param(2).str().c_str());
 					channel->setClientLimit(limit);
 					processedModes += modeChar;
-					std::cout << "Client limit set to " << limit << " for channel <" << channelName << ">" << std::endl;
+					LOG_DEBUG(COMMAND, "Client limit set to " << limit << " for channel <" << channelName << ">");
 				} else {
 					response = IrcMessageFormatter::needMoreParams(_serverName, "MODE");
-					send(client->getSocket(), response.c_str(), response.size(), 0);
+					client->queueMessage(response);
 					return;
 				}
 			} else {
 				channel->unsetClientLimit();
 				processedModes += modeChar;
-				std::cout << "Client limit removed from channel <" << channelName << ">" << std::endl;
+				LOG_DEBUG(COMMAND, "Client limit removed from channel <" << channelName << ">");
 			}
 		} else if (modeChar == 'o') {
 			// Operator mode requires target nickname
-			if (args.size() > 3) {
-				std::string targetNick = args[3];
-				Client *targetClient = NULL;
+			if (msg.paramCount() > 2) {
+				std::string targetNick = msg.param(2).str();
+				Client *targetClient = getClientByNickname(targetNick);
 				
-				// Find the target client
-				for (std::vector<Client *>::const_iterator it = channel->getClients().begin(); it != channel->getClients().end(); ++it)
-				{
-					if ((*it)->getNickname() == targetNick) {
-						targetClient = *it;
-						break;
-					}
-				}
-				
-				if (targetClient == NULL) {
+				if (targetClient == NULL || !channel->hasClient(targetClient)) {
 					response = IrcMessageFormatter::noSuchNick(_serverName, client->getNickname(), targetNick);
-					send(client->getSocket(), response.c_str(), response.size(), 0);
+					client->queueMessage(response);
 					return;
 				}
 				
 				if (adding) {
-					channel->setMode('o');
 					channel->addOperator(targetClient);
 					processedModes += modeChar;
-					std::cout << "Operator status granted to " << targetNick << " in channel <" << channelName << ">" << std::endl;
+					LOG_DEBUG(COMMAND, "Operator status granted to " << targetNick << " in channel <" << channelName << ">");
 				} else {
-					channel->unsetMode(modeChar);
 					channel->removeOperator(targetClient);
 					processedModes += modeChar;
-					std::cout << "Operator status removed from " << targetNick << " in channel <" << channelName << ">" << std::endl;
+					LOG_DEBUG(COMMAND, "Operator status removed from " << targetNick << " in channel <" << channelName << ">");
 				}
 			} else {
 				response = IrcMessageFormatter::needMoreParams(_serverName, "MODE");
-				send(client->getSocket(), response.c_str(), response.size(), 0);
+				client->queueMessage(response);
 				return;
 			}
 		} else {
 			response = IrcMessageFormatter::unknownMode(_serverName, client->getNickname(), modeChar);
-			send(client->getSocket(), response.c_str(), response.size(), 0);
+			client->queueMessage(response);
 			return;
 		}
 
     }
     
-    response = IrcMessageFormatter::modeChange(client->getNickname(), channelName, processedModes);
+    response = IrcMessageFormatter::modeChange(client->getPrefix(), channelName, processedModes);
     
     // Notify all clients in the channel
-    for (std::vector<Client *>::const_iterator it = channel->getClients().begin(); it != channel->getClients().end(); ++it)
-    {
-        send((*it)->getSocket(), response.c_str(), response.size(), 0);
-    }
+    channel->broadcast(response);
     
-    std::cout << "Mode " << processedModes << " set for channel <" << channelName << ">" << std::endl;
+    LOG_INFO(COMMAND, "Mode " << processedModes << " set for channel <" << channelName << ">");
 }
 
 
@@ -587,18 +472,18 @@ void	Server::handleMode(Client *client, std::vector<std::string> args)
  */
 void	Server::sendMessageToUser(Client* sender, const std::string& targetNick, const std::string& message)
 {
-	std::string response;
+	IrcLine line;
 
 	Client* target = getClientByNickname(targetNick);
 	if (!target)
 	{
-		response = IrcMessageFormatter::noSuchNick(_serverName, sender->getNickname(), targetNick);
-		send(sender->getSocket(), response.c_str(), response.size(), 0);
+		IrcMessageFormatter::noSuchNick(line, _serverName, sender->getNickname(), targetNick);
+		sender->queueMessage(line);
 		return;
 	}
 
-	response = IrcMessageFormatter::sendMsg(sender->getNickname(), targetNick, message);
-	send(target->getSocket(), response.c_str(), response.size(), 0);
+	IrcMessageFormatter::sendMsg(line, sender->getPrefix(), targetNick, message);
+	target->queueMessage(line);
 }
 
 /**
@@ -608,40 +493,31 @@ void	Server::sendMessageToUser(Client* sender, const std::string& targetNick, co
  */
 void	Server::sendMessageToChannel(Client* sender, const std::string& targetChannel, const std::string& message)
 {
-	std::string response;
+	IrcLine line;
 
 	Channel* target = getChannel(targetChannel);
 
 	// Check the channel exists
 	if (!target)
 	{
-		response = IrcMessageFormatter::noSuchNick(_serverName, sender->getNickname(), targetChannel);
-		send(sender->getSocket(), response.c_str(), response.size(), 0);
+		IrcMessageFormatter::noSuchNick(line, _serverName, sender->getNickname(), targetChannel);
+		sender->queueMessage(line);
 		return;
 	}
 
 	// Check the sender is in the channel
-	if (!sender->isInChannel(targetChannel))
+	if (!sender->isInChannel(target))
 	{
-		response = IrcMessageFormatter::notOnChannel(_serverName, targetChannel);
-		send(sender->getSocket(), response.c_str(), response.size(), 0);
+		IrcMessageFormatter::notOnChannel(line, _serverName, targetChannel);
+		sender->queueMessage(line);
 		return;
 	}
 
 	// Send the message to everyone in the channel except from themselves
-	response = IrcMessageFormatter::sendMsg(sender->getNickname(), targetChannel, message);
+	IrcMessageFormatter::sendMsg(line, sender->getPrefix(), targetChannel, message);
 
-	const std::vector<Client*>& clients = target->getClients();
-	std::vector<Client*>::const_iterator it = clients.begin();
-	while (it != clients.end())
-	{
-		if ((*it)->getNickname() != sender->getNickname())
-		{
-			std::cout << "sending msg: " << message << " to " << (*it)->getNickname() << std::endl;
-			send((*it)->getSocket(), response.c_str(), response.size(), 0);
-		}
-		it++;
-	}
+	LOG_DEBUG(COMMAND, "sending msg: " << message << " to " << target->getName());
+	target->broadcast(line, sender);
 }
 
 
@@ -650,38 +526,22 @@ void	Server::sendMessageToChannel(Client* sender, const std::string& targetChann
  * It checks if the command syntax is correct and sends the message to the appropriate target.
  * SYNTAX : PRIVMSG <target> :<message>
  */
-void	Server::handlePrivmsg(Client *client, std::vector<std::string> args)
+void	Server::handlePrivmsg(Client *client, const IrcMessage &msg)
 {
-	std::cout << "Entered Handle Privmsg function" << std::endl;
+	LOG_DEBUG(COMMAND, "Entered Handle Privmsg function");
 	std::string response;
 	std::string target;
 	std::string message;
 
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
-
-	if (args.size() < 3)
-	{
-		response = IrcMessageFormatter::needMoreParams(_serverName, "PRIVMSG");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}
-
-	if (args.size() > 3)
+	if (msg.paramCount() > 2)
 	{
 		// to modify to invalid syntax ->what error?
 		response = IrcMessageFormatter::needMoreParams(_serverName, "PRIVMSG");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	target = args[1];
-	message = args[2];
-	if (message[0] == ':')
-		message.erase(0, 1);
+	target = msg.param(0).str();
+	message = msg.param(1).str();
 	if (target[0] == '#')
 		sendMessageToChannel(client, target, message);
 	else
@@ -695,59 +555,45 @@ void	Server::handlePrivmsg(Client *client, std::vector<std::string> args)
  * If the channel does not exist, it creates a new channel.
  * SYNTAX : JOIN <channel> [<key>]
  */
-void	Server::handleJoin(Client *client, std::vector<std::string> args)
+void	Server::handleJoin(Client *client, const IrcMessage &msg)
 {
-	std::cout << "Entered Handle Join function" << std::endl;
+	LOG_DEBUG(COMMAND, "Entered Handle Join function");
 	std::string response;
-	
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
 
-	if (args.size() < 2) {
-		response = IrcMessageFormatter::needMoreParams(_serverName, "JOIN");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}	
-
-	std::string command = args[0];
-	std::string channelName = args[1];
-	std::string key = args.size() > 2 ? args[2] : ""; 
+	std::string channelName = msg.param(0).str();
+	std::string key = msg.param(1).str();
 
-	std::cout << "key in handleJoin: " << key << std::endl;
+	LOG_DEBUG(COMMAND, "key in handleJoin: " << key);
 	if (channelName[0] != '#') {
 		response = IrcMessageFormatter::badChannelMask(_serverName, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 
 	Channel *channel = this->getChannel(channelName);
 	if (channel == NULL) {
 		channel = this->createChannel(channelName, key, client);
-		std::cout << "Channel <" << channelName << "> created." << std::endl;
+		LOG_INFO(COMMAND, "Channel <" << channelName << "> created.");
 	}
 	else {
-		if (client->isInChannel(channelName)) {
+		if (client->isInChannel(channel)) {
 			response = IrcMessageFormatter::userAlreadyOnChannel(_serverName, client->getNickname(), channelName);
-			send(client->getSocket(), response.c_str(), response.size(), 0);
+			client->queueMessage(response);
 			return;
 		}
 		if (channel->hasKey() && !channel->checkKey(key)) {
 			response = IrcMessageFormatter::badChannelKey(_serverName, channelName);
-			send(client->getSocket(), response.c_str(), response.size(), 0);
+			client->queueMessage(response);
 			return;
 		}
 		if (channel->isFull()) {
 			response = IrcMessageFormatter::channelIsFull(_serverName, channelName);
-			send(client->getSocket(), response.c_str(), response.size(), 0);
+			client->queueMessage(response);
 			return;
 		}
-		if (channel->hasMode('i') && !channel->isInvited(client)) {
+		if (channel->hasMode(Channel::MODE_INVITE_ONLY) && !channel->isInvited(client)) {
 			response = IrcMessageFormatter::inviteOnlyChannel(_serverName, client->getNickname(), channelName);
-			send(client->getSocket(), response.c_str(), response.size(), 0);
+			client->queueMessage(response);
 			return;
 		}
 	}
@@ -757,26 +603,33 @@ void	Server::handleJoin(Client *client, std::vector<std::string> args)
 
 	channel->addClient(client);
 	client->joinChannel(channel);
-	response = IrcMessageFormatter::join(client->getNickname(), client->getUsername(), _serverIp, channelName);
-	channel->broadcast(response);
-	std::cout << "Client <" << client->getSocket() << "> has joined channel <" << channelName << ">" << std::endl;
+	IrcLine line;
+	IrcMessageFormatter::join(line, client->getPrefix(), channelName);
+	channel->broadcast(line);
+	LOG_INFO(COMMAND, "Client <" << client->getSocket() << "> has joined channel <" << channelName << ">");
 
 
 	std::ostringstream oss;
 
-	std::vector<Client*> chanClients = channel->getClients();
-	for (unsigned int i = 0; i < chanClients.size(); i++)
+	const Channel::MemberMap &members = channel->getMembers();
+	for (Channel::MemberMap::const_iterator it = members.begin(); it != members.end(); ++it)
 	{
-		if (channel->isOperator(chanClients[i]))
+		if (!(it->second & Channel::MEMBER))
+			continue;
+		if (it->second & Channel::OPERATOR)
 			oss << "@";
-		oss << chanClients[i]->getNickname() << " ";
+		else if (it->second & Channel::VOICE)
+			oss << "+";
+		oss << it->first->getNickname() << " ";
 	}
 	std::string nickList = oss.str();
 
-        response = IrcMessageFormatter::namesReply(_serverName, client->getNickname(), channelName, nickList);
-	send(client->getSocket(), response.c_str(), response.size(), 0);
-        response = IrcMessageFormatter::endOfNames(_serverName, client->getNickname(), channelName);
-	send(client->getSocket(), response.c_str(), response.size(), 0);
+	line.clear();
+	IrcMessageFormatter::namesReply(line, _serverName, client->getNickname(), channelName, nickList);
+	client->queueMessage(line);
+	line.clear();
+	IrcMessageFormatter::endOfNames(line, _serverName, client->getNickname(), channelName);
+	client->queueMessage(line);
 }
 
 
@@ -786,40 +639,29 @@ void	Server::handleJoin(Client *client, std::vector<std::string> args)
  * If the channel becomes empty after the client leaves, it removes the channel.
  * SYNTAX : PART <channel>
  */
-void	Server::handlePart(Client *client, std::vector<std::string> args)
+void	Server::handlePart(Client *client, const IrcMessage &msg)
 {
 	std::string response;
-	if (!client->isRegistered())
-	{
-		response = IrcMessageFormatter::notRegistered(_serverName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return ;
-	}
 
-	if (args.size() == 1) {
-		response = IrcMessageFormatter::needMoreParams(_serverName, "PART");
-		send(client->getSocket(), response.c_str(), response.size(), 0);
-		return;
-	}	
-
-	std::string channelName = args[1];
+	std::string channelName = msg.param(0).str();
 	Channel *channel = this->getChannel(channelName);
 	if (channel == NULL) {
 		response = IrcMessageFormatter::notOnChannel(_serverName, channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
-	if (!client->isInChannel(channelName)) {
+	if (!client->isInChannel(channel)) {
 		response = IrcMessageFormatter::userNotInChannel(_serverName, client->getNickname(), channelName);
-		send(client->getSocket(), response.c_str(), response.size(), 0);
+		client->queueMessage(response);
 		return;
 	}
 
-	response = IrcMessageFormatter::part(client->getNickname(), client->getUsername(), client->getServername(), channelName);
-	channel->broadcast(response);
+	IrcLine line;
+	IrcMessageFormatter::part(line, client->getPrefix(), channelName);
+	channel->broadcast(line);
 	client->leaveChannel(channel);
 	channel->removeClient(client);
-	std::cout << "Client <" << client->getSocket() << "> has left channel <" << channelName << ">" << std::endl;
+	LOG_INFO(COMMAND, "Client <" << client->getSocket() << "> has left channel <" << channelName << ">");
 
 	if (channel->isEmpty()) {
 		this->removeChannel(channelName);
@@ -827,31 +669,35 @@ void	Server::handlePart(Client *client, std::vector<std::string> args)
 
 }
 
-void	Server::handleQuit(Client *client, std::vector<std::string> args)
+void	Server::handleQuit(Client *client, const IrcMessage &msg)
 {
-	(void)args;
-
-	std::cout << "Entered handleQuit -> disconnecting client " << client->getNickname() << std::endl;
-	disconnectClient(client->getSocket());
+	LOG_DEBUG(COMMAND, "Entered handleQuit -> disconnecting client " << client->getNickname());
+	if (msg.paramCount() > 0 && !msg.param(0).empty())
+		disconnectClient(client, msg.param(0).str());
+	else
+		disconnectClient(client);
 }
 
 
-void	Server::handlePing(Client *client, std::vector<std::string> args)
+void	Server::handlePing(Client *client, const IrcMessage &msg)
 {
-	if (args.size() != 2)
+	if (msg.paramCount() != 1)
 		return;
-	std::string message = args[1];
+	std::string message = msg.param(0).str();
 
-	std::string response = IrcMessageFormatter::pong(message);
-	send(client->getSocket(), response.c_str(), response.size(), 0);
-	std::cout << "Sent pong to " << client->getNickname() << std::endl;
+	IrcLine line;
+	IrcMessageFormatter::pong(line, message);
+	client->queueMessage(line);
+	LOG_DEBUG(COMMAND, "Sent pong to " << client->getNickname());
 }
 
 
-void	Server::handlePong(Client *client, std::vector<std::string> args)
+void	Server::handlePong(Client *client, const IrcMessage &msg)
 {
-	(void) args;
-	std::cout << "Received a pong from " << client->getNickname() << std::endl;
+	(void)msg;
+	client->setLastPongTime(time(NULL));
+	client->setPingReceived(false);
+	LOG_DEBUG(COMMAND, "Received a pong from " << client->getNickname());
 }
 
 
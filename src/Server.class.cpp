@@ -1,47 +1,88 @@
 #include "../include/Server.class.hpp"
 #include <errno.h>
 #include <cstring>
+#include <cctype>
 
-bool Server::_signal = false;
+volatile sig_atomic_t Server::_signal = false;
 
-Server::Server(long port, const std::string &password)
-	: _port(port), _password(password), _socketFd(-1), _serverName("ft_irc_server"), _serverVersion("1.0")
+Server::Server(long port, const std::string &password, size_t workerCount)
+	: _port(port), _password(password), _workerCount(workerCount ? workerCount : 1),
+	  _serverName("ft_irc_server"), _serverVersion("1.0"), _clientCount(0),
+	  _floodBurst(DEFAULT_FLOOD_BURST), _floodRate(DEFAULT_FLOOD_RATE), _commandBudget(DEFAULT_COMMAND_BUDGET)
 {
+	_connectionThrottle.configure(DEFAULT_CONNECTION_BURST, DEFAULT_CONNECTION_RATE);
 }
 
 
-Server::~Server()
+void Server::setFloodControl(unsigned long burst, unsigned long rate)
 {
-	// delete the channels
-	for (std::vector<Channel*>::iterator it = _channels.begin(); it != _channels.end(); ++it)
-		delete *it;
-	_channels.clear();
+	_floodBurst = burst;
+	_floodRate = rate;
+}
 
-	// delete the clients
-	for (std::vector<Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it)
-		delete *it;
-	_clients.clear();
 
-	// close the socket of the server
-	if (_socketFd >= 0)
-		close(_socketFd);
+void Server::setCommandBudget(unsigned long budget)
+{
+	_commandBudget = budget;
+}
+
 
-	_pollFds.clear();
-    	_commandHandlers.clear();
+void Server::setConnectionThrottle(unsigned long burst, unsigned long rate)
+{
+	_connectionThrottle.configure(burst, rate);
 }
 
 
-void Server::init()
+Server::~Server()
+{
+	// give the channels back first, they drop the invitations held by clients
+	for (ChannelList::iterator it = _channels.begin(); it != _channels.end(); ++it)
+		_channelPool.release(*it);
+	_channels.clear();
+	_channelIndex.clear();
+
+	// close and release the clients, then delete the workers (which close their listening sockets)
+	for (size_t i = 0; i < _workers.size(); ++i)
+	{
+		const std::vector<Client*> &clients = _workers[i]->getClients();
+		for (std::vector<Client*>::const_iterator it = clients.begin(); it != clients.end(); ++it)
+		{
+			if (*it == NULL)
+				continue;
+			_workers[i]->getTimers().cancel((*it)->getTimer());
+			close((*it)->getSocket());
+			_clientPool.release(*it);
+		}
+		delete _workers[i];
+	}
+	_workers.clear();
+	_clientCount = 0;
+}
+
+
+/**
+ * @description Creates a listening socket on the server port. With several
+ * workers every one of them gets its own, bound with SO_REUSEPORT, and the
+ * kernel spreads the incoming connections between them.
+ */
+int Server::openListener()
 {
-	_socketFd = socket(AF_INET, SOCK_STREAM, 0);
-	if (_socketFd < 0)
+	// Non-blocking, so that the accept loop stops when the backlog is empty
+	int socketFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (socketFd < 0)
 	{
 		std::cerr << "Error creating socket: " << strerror(errno) << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
 	int opt = 1;
-	setsockopt(_socketFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	if (_workerCount > 1 && setsockopt(socketFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+	{
+		std::cerr << "Error setting SO_REUSEPORT: " << strerror(errno) << std::endl;
+		close(socketFd);
+		exit(EXIT_FAILURE);
+	}
 
 	struct sockaddr_in serverAddr;
 	serverAddr.sin_family = AF_INET;
@@ -49,33 +90,42 @@ void Server::init()
 	serverAddr.sin_port = htons(_port);
 	
 
-	if (bind(_socketFd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
+	if (bind(socketFd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
 	{
 		std::cerr << "Error binding socket: " << strerror(errno) << std::endl;
-		close(_socketFd);
+		close(socketFd);
 		
 		exit(EXIT_FAILURE);
 	}
 
-	if (listen(_socketFd, SOMAXCONN) < 0)
+	if (listen(socketFd, SOMAXCONN) < 0)
 	{
 		std::cerr << "Error listening on socket: " << strerror(errno) << std::endl;
-		close(_socketFd);
+		close(socketFd);
 		
 		exit(EXIT_FAILURE);
 	}
+	return socketFd;
+}
 
-	struct pollfd serverPollfd;
-	bzero(&serverPollfd, sizeof(pollfd));
-	serverPollfd.fd = _socketFd;
-	serverPollfd.events = POLLIN;
-	_pollFds.push_back(serverPollfd);
+
+void Server::init()
+{
+	for (size_t i = 0; i < _workerCount; ++i)
+	{
+		Worker *worker = new Worker(this, i);
+		_workers.push_back(worker);
+		if (!worker->init(openListener()))
+		{
+			std::cerr << "Error creating the event loop: " << strerror(errno) << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
 
 	struct ifaddrs *ifaddr, *ifa;
 	if (getifaddrs(&ifaddr) == -1)
 	{
 		std::cerr << "Error getting network interfaces: " << strerror(errno) << std::endl;
-		close(_socketFd);
 		exit(EXIT_FAILURE);
 	}
 	for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next)
@@ -95,13 +145,13 @@ void Server::init()
 	{
 		std::cerr << "No suitable network interface found." << std::endl;
 		freeifaddrs(ifaddr);
-		close(_socketFd);
 		exit(EXIT_FAILURE);
 	}
 	freeifaddrs(ifaddr);
-	this->setupCommandHandlers();
 
-	std::cout << "Server initialized and listening on port " << _serverIp << ":" << _port << std::endl;
+	LOG_INFO(SERVER, "Server initialized and listening on port " << _serverIp << ":" << _port
+		<< " (" << EventLoop::backendName() << " backend, " << _workerCount << " worker"
+		<< (_workerCount > 1 ? "s" : "") << ")");
 }
 
 
@@ -113,159 +163,547 @@ void Server::signalHandler(int signum)
 }
 
 
-void Server::acceptNewClient()
+/**
+ * @description Accepts every connection waiting on the listener of the worker,
+ * until accept4() reports that the backlog is empty. The sockets come out
+ * non-blocking and close-on-exec, without extra fcntl() calls. Addresses
+ * that connect faster than the connection throttle allows are refused
+ * before a client is taken from the pool.
+ */
+void Server::acceptNewClients(Worker &worker)
 {
-	struct sockaddr_in cliadd;
-	struct pollfd NewPoll;
-	socklen_t len = sizeof(cliadd);
+	while (true)
+	{
+		struct sockaddr_in cliadd;
+		socklen_t len = sizeof(cliadd);
+
+		int incofd = accept4(worker.getListenFd(), (sockaddr *)&cliadd, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (incofd == -1)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;	// that connection is gone, not the others
+			if (errno == EMFILE || errno == ENFILE)
+			{
+				// Out of descriptors: left in the backlog, the connection would
+				// wake the level-triggered listener again at once
+				int error = errno;
+				unsigned long now = TimerWheel::nowMs();
+				unsigned long count;
+				if (worker.fdWarningDue(now, count))
+					LOG_WARN(NET, "accept4() failed: " << strerror(error) << ", refusing connections ("
+						<< count << " since the last warning)");
+				if (worker.refusePendingConnection())
+					continue;
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+					worker.pauseListener(now);	// no spare descriptor either
+				return;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				LOG_WARN(NET, "accept4() failed: " << strerror(errno));
+			return;
+		}
+
+		if (!_connectionThrottle.allow(cliadd.sin_addr.s_addr, TimerWheel::nowMs()))
+		{
+			char ip[INET_ADDRSTRLEN];
+			inet_ntop(AF_INET, &cliadd.sin_addr, ip, sizeof(ip));
+			LOG_WARN(NET, "Refused a connection from " << ip << ": too many connections");
+			IrcLine line;
+			IrcMessageFormatter::closingLink(line, ip, "Too many connections from your address");
+			send(incofd, line.data(), line.size(), MSG_DONTWAIT | MSG_NOSIGNAL);	// best effort
+			close(incofd);
+			continue;
+		}
+		addNewClient(worker, incofd, cliadd);
+	}
+}
 
-	int incofd = accept(_socketFd, (sockaddr *)&(cliadd), &len); //-> accept the new client
-	if (incofd == -1)
+
+void Server::addNewClient(Worker &worker, int incofd, const sockaddr_in &cliadd)
+{
+	if (!worker.getLoop().add(incofd, EventLoop::READ)) //-> watch the client socket for incoming data
 	{
-		std::cout << "accept() failed" << std::endl;
+		LOG_WARN(NET, "Failed to register client <" << incofd << "> in the event loop");
+		close(incofd);
 		return;
 	}
 
-	if (fcntl(incofd, F_SETFL, O_NONBLOCK) == -1) //-> set the socket option (O_NONBLOCK) for non-blocking socket
+	char ip[INET_ADDRSTRLEN];	// inet_ntoa() is not thread-safe
+	inet_ntop(AF_INET, &cliadd.sin_addr, ip, sizeof(ip));
+	Client *cli;
 	{
-		std::cout << "fcntl() failed" << std::endl;
-		return;
+		ScopedLock lock(_stateLock);
+		cli = _clientPool.acquire();							//-> reuse a pooled client
+		_clientCount++;
 	}
+	cli->init(incofd, ip, &worker);
+	cli->getFloodBucket().reset(_floodBurst, _floodRate, TimerWheel::nowMs());
+	worker.addClient(cli);										//-> the fd is the slot of the client in its worker
+	worker.getTimers().schedule(cli->getTimer(), REGISTRATION_TIMEOUT * 1000);
 
-	NewPoll.fd = incofd;	 //-> add the client socket to the pollfd
-	NewPoll.events = POLLIN; //-> set the event to POLLIN for reading data
-	NewPoll.revents = 0;	 //-> set the revents to 0
+	LOG_INFO(NET, "Client <" << incofd << "> Connected");
+}
 
-	Client *cli = new Client(incofd, inet_ntoa((cliadd.sin_addr))); //-> create a new client
 
-	_clients.push_back(cli);										//-> add the client to the vector of clients
-	_pollFds.push_back(NewPoll);									//-> add the client socket to the pollfd
+/**
+ * @description Runs the workers until SIGINT/SIGQUIT. The first worker uses
+ * the main thread, the others get their own thread with those signals blocked
+ * so that the main thread is the one interrupted.
+ */
+void Server::run(void)
+{
+	if (_workers.size() == 1)
+	{
+		runWorker(*_workers[0]);
+		return ;
+	}
 
-	std::cout << "Client <" << incofd << "> Connected" << std::endl;
+	sigset_t blocked, previous;
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGQUIT);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	for (size_t i = 1; i < _workers.size(); ++i)
+	{
+		if (_workers[i]->start(&Server::workerMain))
+			continue;
+		// Its listener is bound and would get a share of the connections
+		// with nobody to accept them: stop the workers already running
+		std::string error = strerror(errno);
+		pthread_sigmask(SIG_SETMASK, &previous, NULL);
+		_signal = true;
+		wakeWorkers();
+		for (size_t j = 1; j < i; ++j)
+			_workers[j]->join();
+		LOG_ERROR(SERVER, "Failed to start worker " << i << ": " << error);
+		throw(std::runtime_error("Failed to start worker thread: " + error));
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+	try
+	{
+		runWorker(*_workers[0]);
+	}
+	catch (...)
+	{
+		_signal = true;
+		wakeWorkers();
+		for (size_t i = 1; i < _workers.size(); ++i)
+			_workers[i]->join();
+		throw ;
+	}
+	_signal = true;
+	wakeWorkers();
+	for (size_t i = 1; i < _workers.size(); ++i)
+		_workers[i]->join();
 }
 
 
-void Server::run(void)
+void *Server::workerMain(void *arg)
+{
+	Worker *worker = static_cast<Worker *>(arg);
+	Server *server = worker->getServer();
+	try
+	{
+		server->runWorker(*worker);
+	}
+	catch (const std::exception &e)
+	{
+		LOG_ERROR(SERVER, "Worker " << worker->getId() << ": " << e.what());
+		_signal = true;	// one dead shard takes the server down
+		server->wakeWorkers();
+	}
+	return (NULL);
+}
+
+
+void Server::wakeWorkers()
 {
+	for (size_t i = 0; i < _workers.size(); ++i)
+		_workers[i]->wake();
+}
+
+
+void Server::runWorker(Worker &worker)
+{
+	std::vector<EventLoop::Event> events;
+	std::vector<TimerWheel::Timer *> expired;
+	std::vector<int> queued;
+	std::vector<Client *> removed;
+
+	worker.bindToCurrentThread();
 	while (_signal == false)
 	{
-		if ((poll(&_pollFds[0], _pollFds.size(), -1) == -1) && Server::_signal == false)
+		// Sleep until the next tick of the timer wheel at most, and no longer
+		// than until the first queued client has the tokens for its next line
+		unsigned long now = TimerWheel::nowMs();
+		int timeout = worker.getTimers().timeoutMs(now);
+		int inputTimeout = worker.inputTimeoutMs(now);
+		if (inputTimeout >= 0 && (timeout < 0 || inputTimeout < timeout))
+			timeout = inputTimeout;
+		if (worker.isListenerPaused() && (timeout < 0 || timeout > static_cast<int>(Worker::LISTENER_RETRY_MS)))
+			timeout = Worker::LISTENER_RETRY_MS;
+		if ((worker.getLoop().wait(events, timeout) == -1) && Server::_signal == false)
 		{
-			throw(std::runtime_error("poll() failed"));
+			throw(std::runtime_error(std::string(EventLoop::backendName()) + " wait failed"));
 		}
+		unsigned long busySince = Worker::monotonicUs();
 
-		for (size_t i = 0; i < _pollFds.size(); i++)
+		// Clients queued by earlier iterations get their turn after the
+		// sockets: the ones queued now wait for the next iteration
+		worker.takeInputQueue(queued);
+
+		// Only the ready sockets are visited
+		for (size_t i = 0; i < events.size(); i++)
 		{
-			if (_pollFds[i].revents & POLLIN)
+			if (events[i].fd == worker.getListenFd())
+			{
+				acceptNewClients(worker);
+				continue;
+			}
+			if (worker.isWakeFd(events[i].fd))
 			{
-				if (_pollFds[i].fd == _socketFd)
-					acceptNewClient();
-				else
-					receiveNewData(_pollFds[i].fd);
+				worker.drainWakeups();	// other workers queued output for our clients
+				continue;
 			}
+			if (events[i].events & EventLoop::WRITE)
+			{
+				Client *client = worker.getClient(events[i].fd);
+				if (client)
+					flushClient(client);
+			}
+			if (events[i].events & (EventLoop::READ | EventLoop::HANGUP | EventLoop::ERROR))
+				receiveNewData(worker, events[i].fd);
 		}
+
+		processInputQueue(worker, queued);
+
+		// Send everything queued for our clients during this iteration
+		flushPendingOutput(worker);
+
+		expireTimers(worker, expired);
+
+		// Nothing refers to the clients disconnected above any more
+		reapClients(worker, removed);
+		worker.retryListener(TimerWheel::nowMs(), !removed.empty());
+		worker.recordIteration(Worker::monotonicUs() - busySince);
 	}
 }
 
 
-void Server::receiveNewData(int fd)
+/**
+ * @description Runs the deadlines of the clients of the worker that are due.
+ * Each client has one timer, armed for its next deadline: the end of the
+ * registration window, then the next keepalive check. Traffic does not
+ * touch the wheel, the check compares the time of the last activity and
+ * re-arms the timer for the rest of the interval.
+ */
+void Server::expireTimers(Worker &worker, std::vector<TimerWheel::Timer *> &expired)
 {
-	char buff[1024];
-	memset(buff, 0, sizeof(buff));
-	
-	size_t bytes = recv(fd, buff, sizeof(buff) - 1, 0);
+	expired.clear();
+	worker.getTimers().advance(TimerWheel::nowMs(), expired);
+	if (expired.empty())
+		return;
 
-	if (bytes <= 0)
-		disconnectClient(fd);
-	else
+	ScopedLock lock(_stateLock);
+	time_t now = time(NULL);
+	for (size_t i = 0; i < expired.size(); ++i)
 	{
-		// PARSE THE DATA AND PROCESS IT
-		buff[bytes] = '\0';
-		std::cout << "Server received data from Client <" << fd << ">: " << buff << std::endl;
+		Client *client = static_cast<Client *>(expired[i]->owner);
+		if (worker.getClient(client->getSocket()) != client)
+			continue;
 
-		Client *client = getClient(fd);
-		if (!client)
-			return ;
+		if (!client->isRegistered())
+		{
+			LOG_INFO(NET, "Client <" << client->getSocket() << "> did not register in time");
+			disconnectClient(client, "Registration timeout");
+			continue;
+		}
+		if (client->isPingReceived())
+		{
+			LOG_INFO(NET, "Client <" << client->getSocket() << "> did not answer PING");
+			disconnectClient(client, "Ping timeout");
+			continue;
+		}
 
-		// Extract and process complete lines
-		std::string &buffer = client->getMessageBuffer();
-		buffer += buff;
-		size_t pos;
-		while ((pos = buffer.find('\n')) != std::string::npos)
+		time_t idle = now - client->getLastActivityTime();
+		if (idle >= 0 && static_cast<unsigned long>(idle) < PING_INTERVAL)
 		{
-			std::string line = buffer.substr(0, pos);
-			buffer.erase(0, pos + 1); // Remove up to and including '\n'
+			worker.getTimers().schedule(client->getTimer(), (PING_INTERVAL - idle) * 1000);
+			continue;
+		}
+		IrcLine line;
+		IrcMessageFormatter::ping(line, _serverName);
+		client->queueMessage(line);
+		client->setPingReceived(true);
+		worker.getTimers().schedule(client->getTimer(), PING_TIMEOUT * 1000);
+	}
+	flushPendingOutput(worker);
+}
+
 
-			// Optionally strip trailing \r
-			if (line.size() > 0 && line[line.size() - 1] == '\r')
-    			line.erase(line.size() - 1, 1);
+void Server::receiveNewData(Worker &worker, int fd)
+{
+	Client *client = worker.getClient(fd);
+	if (!client || client->isClosing())
+		return ;	// a closing client is not read any more
+
+	LineBuffer &buffer = client->getRecvBuffer();
 
-			handleCommand(client, line); // Pass full command to command handler
-			if (!getClient(fd))
-				return ;
+	// Drain the socket: read straight into the buffer until there is nothing left
+	while (true)
+	{
+		buffer.compact();
+		if (buffer.writable() == 0)
+		{
+			// Out of budget only: the rest waits in the socket for its turn
+			if (client->isInputQueued() && !client->isThrottled())
+				break;
+			// Lines held back by flood control filled it: the hard limit
+			LOG_WARN(NET, "Client <" << fd << "> exceeded the flood limit");
+			ScopedLock lock(_stateLock);
+			disconnectClient(client, "Excess Flood");
+			break;
+		}
+		ssize_t bytes = recv(fd, buffer.writePtr(), buffer.writable(), 0);
+		if (bytes == -1 && errno == EINTR)
+			continue;
+		if (bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (bytes <= 0)
+		{
+			ScopedLock lock(_stateLock);
+			disconnectClient(client);
+			break;
 		}
+
+		// Handlers read and change state shared by every worker
+		ScopedLock lock(_stateLock);
+		client->updateLastActivity();	// any traffic answers a pending PING
+		client->setPingReceived(false);
+		LOG_DEBUG(NET, "Server received data from Client <" << fd << ">: "
+			<< std::string(buffer.writePtr(), bytes));
+		buffer.commit(bytes);
+
+		// A queued client runs its lines on its turn, after the ones it already has
+		if (!client->isInputQueued())
+			processInput(worker, client);
+		if (client->isClosing())
+			break ;
+	}
+}
+
+
+// Positions in _commandTable, used by the switch in findCommand
+enum CommandId
+{
+	CMD_NICK, CMD_PASS, CMD_USER, CMD_QUIT,
+	CMD_KICK, CMD_INVITE, CMD_TOPIC, CMD_MODE,
+	CMD_PRIVMSG, CMD_JOIN, CMD_PART, CMD_PING, CMD_PONG,
+	CMD_PRINTCHANNELS, CMD_PRINTSTATS, CMD_TIME, CMD_RPS
+};
+
+const Server::CommandSpec Server::_commandTable[] =
+{
+	// name             handler                            params  registered  cost
+	{ "NICK",           &Server::handleNick,               0,      false,      2 },
+	{ "PASS",           &Server::handlePass,               1,      false,      1 },
+	{ "USER",           &Server::handleUser,               4,      false,      1 },
+	{ "QUIT",           &Server::handleQuit,               0,      false,      1 },
+	{ "KICK",           &Server::handleKick,               2,      true,       2 },
+	{ "INVITE",         &Server::handleInvite,             2,      true,       2 },
+	{ "TOPIC",          &Server::handleTopic,              1,      true,       2 },
+	{ "MODE",           &Server::handleMode,               1,      true,       2 },
+	{ "PRIVMSG",        &Server::handlePrivmsg,            2,      true,       1 },
+	{ "JOIN",           &Server::handleJoin,               1,      true,       2 },
+	{ "PART",           &Server::handlePart,               1,      true,       1 },
+	{ "PING",           &Server::handlePing,               0,      false,      1 },
+	{ "PONG",           &Server::handlePong,               0,      false,      1 },
+	{ "PRINTCHANNELS",  &Server::printChannels,            0,      false,      1 },
+	{ "PRINTSTATS",     &Server::printStats,               0,      false,      1 },
+	{ "TIME",           &Server::handleBot,                0,      true,       1 }, // Test for bot
+	{ "RPS",            &Server::handleRockPaperScissors,  0,      true,       1 }
+};
+
+
+// Commands are case-insensitive, the table holds them in upper case
+static bool sameCommand(const StringView &name, const char *command)
+{
+	for (size_t i = 0; i < name.size(); ++i)
+	{
+		if (command[i] == '\0' || toupper(static_cast<unsigned char>(name[i])) != command[i])
+			return (false);
+	}
+	return (command[name.size()] == '\0');
+}
+
+
+// Picks the only candidate from the length and the first letters, then confirms it
+const Server::CommandSpec *Server::findCommand(const StringView &name)
+{
+	if (name.empty())
+		return (NULL);
+
+	int id = -1;
+	char first = toupper(static_cast<unsigned char>(name[0]));
+	switch (name.size())
+	{
+		case 3:
+			if (first == 'R')
+				id = CMD_RPS;
+			break;
+		case 4:
+			switch (first)
+			{
+				case 'N': id = CMD_NICK; break;
+				case 'U': id = CMD_USER; break;
+				case 'Q': id = CMD_QUIT; break;
+				case 'K': id = CMD_KICK; break;
+				case 'M': id = CMD_MODE; break;
+				case 'J': id = CMD_JOIN; break;
+				case 'T': id = CMD_TIME; break;
+				case 'P':
+					switch (toupper(static_cast<unsigned char>(name[1])))
+					{
+						case 'A':
+							id = (toupper(static_cast<unsigned char>(name[2])) == 'S') ? CMD_PASS : CMD_PART;
+							break;
+						case 'I': id = CMD_PING; break;
+						case 'O': id = CMD_PONG; break;
+					}
+					break;
+			}
+			break;
+		case 5:
+			if (first == 'T')
+				id = CMD_TOPIC;
+			break;
+		case 6:
+			if (first == 'I')
+				id = CMD_INVITE;
+			break;
+		case 7:
+			if (first == 'P')
+				id = CMD_PRIVMSG;
+			break;
+		case 10:
+			if (first == 'P')
+				id = CMD_PRINTSTATS;
+			break;
+		case 13:
+			if (first == 'P')
+				id = CMD_PRINTCHANNELS;
+			break;
 	}
+	if (id == -1 || !sameCommand(name, _commandTable[id].name))
+		return (NULL);
+	return (&_commandTable[id]);
 }
 
-// Splits the input by spaces, except when found ':' is keeps all the rest including spaces
-// "USER" "casey" "casey" "casey" ":Casey Christina Burgess"
-std::vector<std::string> split(std::string& line)
+
+/**
+ * @description Runs at most _commandBudget complete lines of the client,
+ * as long as its token bucket can pay for them. The first line left over
+ * stays in the receive buffer and the client is queued on its worker, which
+ * gives it another turn on a later iteration: a chatty client cannot hold
+ * the loop, and the others get their turn in between. Called with
+ * _stateLock held; stops as soon as a handler disconnects the client.
+ */
+void Server::processInput(Worker &worker, Client *client)
 {
-	std::istringstream iss(line);
-	std::string buffer;
-	std::vector<std::string> args;
-	while (iss >> buffer)
+	LineBuffer &buffer = client->getRecvBuffer();
+	unsigned long now = TimerWheel::nowMs();
+	unsigned long handled = 0;
+	IrcMessage msg;
+	const char *line;
+	size_t length;
+
+	// Complete lines are parsed where they are, without copying them out
+	while (buffer.nextLine(line, length))
 	{
-		if (buffer[0] == ':')
+		if (!msg.parse(line, length))
+			continue;
+		bool outOfBudget = (handled == _commandBudget);
+		unsigned long cost = outOfBudget ? 0 : commandCost(msg);
+		if (outOfBudget || !client->getFloodBucket().tryTake(cost, now))
 		{
-			size_t pos = line.find(':');
-			buffer = line.substr(pos);
-			args.push_back(buffer);
-			return (args);
+			buffer.unread(line);
+			client->setThrottled(!outOfBudget);
+			client->setInputQueued(true);
+			worker.queueInput(client->getSocket(), now + client->getFloodBucket().waitMs(cost));
+			return;
 		}
-		args.push_back(buffer);
+		handleCommand(client, msg);
+		if (client->isClosing())
+			return;
+		++handled;
 	}
-	return (args);
 }
 
 
-void	Server::setupCommandHandlers()
+// One turn for each client of the queue, in the order they were queued
+void Server::processInputQueue(Worker &worker, std::vector<int> &fds)
 {
-	_commandHandlers["NICK"] = &Server::handleNick;
-	_commandHandlers["PASS"] = &Server::handlePass;
-	_commandHandlers["USER"] = &Server::handleUser;
-	_commandHandlers["KICK"] = &Server::handleKick;
-	_commandHandlers["INVITE"] = &Server::handleInvite;
-	_commandHandlers["TOPIC"] = &Server::handleTopic;
-	_commandHandlers["MODE"] = &Server::handleMode;
-	_commandHandlers["PRIVMSG"] = &Server::handlePrivmsg;
-	_commandHandlers["JOIN"] = &Server::handleJoin;
-	_commandHandlers["PART"] = &Server::handlePart;
-	_commandHandlers["PING"] = &Server::handlePing;
-	_commandHandlers["PONG"] = &Server::handlePong;
-	_commandHandlers["PRINTCHANNELS"] = &Server::printChannels;
-	_commandHandlers["TIME"] = &Server::handleBot; // Test for bot
-	_commandHandlers["RPS"] = &Server::handleRockPaperScissors;
+	if (fds.empty())
+		return;
 
+	ScopedLock lock(_stateLock);
+	for (size_t i = 0; i < fds.size(); ++i)
+	{
+		Client *client = worker.getClient(fds[i]);
+		if (client == NULL || !client->isInputQueued() || client->isClosing())
+			continue;	// gone, or the slot was reused since
+		client->setInputQueued(false);
+		processInput(worker, client);
+	}
+}
+
+
+// Tokens taken by one line: the cost of its command, plus the fan-out of a channel message
+unsigned long Server::commandCost(const IrcMessage &msg)
+{
+	const CommandSpec *command = findCommand(msg.command());
+	if (!command)
+		return 1;
+	unsigned long cost = command->floodCost;
+	if (command->handler == &Server::handlePrivmsg && msg.param(0).size() > 1 && msg.param(0)[0] == '#')
+	{
+		Channel *channel = getChannel(msg.param(0).str());
+		if (channel)
+			cost += channel->getMemberCount() / FLOOD_FANOUT_STEP;
+	}
+	return cost;
 }
 
 
-void Server::handleCommand(Client *client, std::string &line)
+void Server::handleCommand(Client *client, const IrcMessage &msg)
 {
-	std::vector<std::string> args = split(line);
-	if (args.empty())
+	client->getWorker()->countCommand();
+
+	IrcLine errorLine;
+	const CommandSpec *command = findCommand(msg.command());
+	if (!command)
+	{
+		IrcMessageFormatter::unknownCommand(errorLine, _serverName, msg.command().str());
+		client->queueMessage(errorLine);
 		return ;
-	std::string command = args[0];
+	}
 
-	std::map<std::string, void (Server::*)(Client*, std::vector<std::string>)>::iterator it;
-	it = _commandHandlers.find(command);
-	if (it != _commandHandlers.end())
-		(this->*(it->second))(client, args);
-	else
+	// Checks shared by every handler
+	if (command->needsRegistration && !client->isRegistered())
 	{
-		std::string errorResponse = IrcMessageFormatter::unknownCommand(_serverName, command);
-		send(client->getSocket(), errorResponse.c_str(), errorResponse.size(), 0);
+		IrcMessageFormatter::notRegistered(errorLine, _serverName);
+		client->queueMessage(errorLine);
+		return ;
+	}
+	if (msg.paramCount() < command->minParams)
+	{
+		IrcMessageFormatter::needMoreParams(errorLine, _serverName, command->name);
+		client->queueMessage(errorLine);
+		return ;
 	}
+
+	(this->*(command->handler))(client, msg);
 }
 
 
@@ -276,163 +714,300 @@ void	Server::registerClient(Client* client)
 	if (client->isRegistered())
 		return;
 	client->setRegistered(true);
+	client->getWorker()->getTimers().schedule(client->getTimer(), PING_INTERVAL * 1000);
 	this->logNewClient(client);
 
 	response = IrcMessageFormatter::welcome(_serverName, client->getNickname(), client->getRealname(), client->getHostname());
-	send(client->getSocket(), response.c_str(), response.size(), 0);
+	client->queueMessage(response);
 
 	response = IrcMessageFormatter::yourHost(_serverName, client->getNickname(), _serverVersion);
-	send(client->getSocket(), response.c_str(), response.size(), 0);
+	client->queueMessage(response);
 
 	response = IrcMessageFormatter::motdStart(_serverName, client->getNickname());
-	send(client->getSocket(), response.c_str(), response.size(), 0);
+	client->queueMessage(response);
 
 	response = IrcMessageFormatter::motdLine(_serverName, client->getNickname(), "    Have a wonderful day!!   ");
-	send(client->getSocket(), response.c_str(), response.size(), 0);
+	client->queueMessage(response);
 
 	response = IrcMessageFormatter::motdEnd(_serverName, client->getNickname());
-	send(client->getSocket(), response.c_str(), response.size(), 0);
+	client->queueMessage(response);
 
-	std::cout << "Sent MOTD to the client: " << client->getNickname() << std::endl;
+	LOG_DEBUG(CLIENT, "Sent MOTD to the client: " << client->getNickname());
 }
 
-void Server::disconnectClient(int fd)
+// Writes the queued output of the client and watches the socket for
+// writability only while some of it could not be sent yet.
+// Only the worker that owns the client calls it, without _stateLock.
+void Server::flushClient(Client *client)
 {
-	// find the client to remove
-	Client *client = getClient(fd);
+	Worker &worker = *client->getWorker();
+	int fd = client->getSocket();
 
-	// remove client's pollfd from _pollFds
-	for (std::vector<pollfd>::iterator it = _pollFds.begin(); it != _pollFds.end(); ++it)
+	int syscalls = client->flushOutput();
+	if (syscalls == -1)
 	{
-		if (it->fd == fd)
-		{
-			_pollFds.erase(it);
+		ScopedLock lock(_stateLock);
+		disconnectClient(client);
+		return ;
+	}
+	worker.countWriteCalls(syscalls, true);
+	if (client->pendingOutputSize() > Client::MAX_SEND_QUEUE)
+	{
+		LOG_WARN(NET, "Client <" << fd << "> send queue exceeded");
+		ScopedLock lock(_stateLock);
+		disconnectClient(client);
+		return ;
+	}
+
+	bool pending = client->hasPendingOutput();
+	if (pending != client->wantsWrite())
+	{
+		worker.getLoop().modify(fd, pending ? (EventLoop::READ | EventLoop::WRITE) : EventLoop::READ);
+		client->setWantsWrite(pending);
+	}
+}
+
+
+void Server::flushPendingOutput(Worker &worker)
+{
+	std::vector<int> queue;
+
+	// A failed flush disconnects its client, which can queue QUIT lines for others
+	while (true)
+	{
+		worker.takeFlushQueue(queue);
+		if (queue.empty())
 			break;
+
+		for (size_t i = 0; i < queue.size(); ++i)
+		{
+			Client *client = worker.getClient(queue[i]);
+			if (client)
+				flushClient(client);
 		}
 	}
+}
 
-	// remove client from server list
-	_clients.erase(std::remove(_clients.begin(), _clients.end(), client), _clients.end());
-
-	std::string quitMsg = IrcMessageFormatter::quit(client->getNickname(), client->getUsername(),
-	_serverIp, "Leaving");
 
-	std::vector<Channel*> chanCopy = client->getChannelsList();
-	for (size_t i = 0; i < chanCopy.size(); ++i)
+/**
+ * @description Called with _stateLock held, by the worker that owns the
+ * client, possibly from one of its own handlers. The client leaves the
+ * shared state at once (nickname, channels, timer) and is marked closing,
+ * so that none of its input runs any more; it gets a final ERROR line and
+ * its slot and socket stay as they are until reapClients() at the end of
+ * the loop iteration.
+ */
+void Server::disconnectClient(Client *client, const std::string &reason)
+{
+	if (client->isClosing())
+		return ;	// already on its way out
+	Worker &worker = *client->getWorker();
+	int fd = client->getSocket();
+	client->setClosing(true);
+	worker.getTimers().cancel(client->getTimer());
+
+	// free the nickname of the client
+	if (client->hasSentNickname())
+		_nicknames.erase(ircCasemap(client->getNickname()));
+	_clientCount--;
+
+	IrcLine line;
+	IrcMessageFormatter::quit(line, client->getPrefix(), reason);
+	SharedMessage quitMsg(line);
+
+	// Its own channel index is emptied as well: an empty channel goes back to
+	// the pool and may be reused before the client is reaped
+	const Client::ChannelSet &channels = client->getChannelsList();
+	for (Client::ChannelSet::const_iterator it = channels.begin(); it != channels.end(); )
 	{
-		Channel* current = chanCopy[i];
+		Channel* current = *it++;	// leaveChannel() erases the current entry
 		// remove the client from its channel
-		current->removeClient(client);
-		// remove the channel from the client list
 		client->leaveChannel(current);
+		current->removeClient(client);
 
 		// if is empty delete it from server
 		if (current->isEmpty())
 		{
-			_channels.erase(std::remove(_channels.begin(), _channels.end(), current), _channels.end());
-			delete current;
+			removeChannel(current->getName());
 		}
 		else
 			current->broadcast(quitMsg);
 	}
 
-	delete client;
+	LOG_INFO(CLIENT, "📢 Client Disconnected! Nickname: " << client->getNickname() << " Real Name: " << client->getRealname()
+		<< " IP Address: " << client->getIp() << " Socket: " << fd);
+
+	IrcLine closing;
+	IrcMessageFormatter::closingLink(closing, client->getIp(), reason);
+	client->queueMessage(closing);
+	worker.scheduleRemoval(client);
 }
 
 
-Client *Server::getClient(int fd)
+/**
+ * @description Closes the clients disconnected during this iteration, all at
+ * once when every event has been handled: no handler or queued input still
+ * uses them, and their fds cannot be handed to a new connection before the
+ * events of the iteration are done with. Their last replies, ending with the
+ * ERROR line, get one more non-blocking flush before the socket is closed.
+ */
+void Server::reapClients(Worker &worker, std::vector<Client *> &removed)
 {
-	for (size_t i = 0; i < _clients.size(); ++i)
+	worker.takeClientsToRemove(removed);
+	if (removed.empty())
+		return ;
+
+	for (size_t i = 0; i < removed.size(); ++i)
 	{
-		if (_clients[i]->getSocket() == fd) {
-			return _clients[i];
-		}
+		Client *client = removed[i];
+		int fd = client->getSocket();
+		if (client->hasPendingOutput())
+			worker.countWriteCalls(std::max(client->flushOutput(), 0), false);
+		worker.getLoop().remove(fd);
+		worker.removeClient(fd);
+		shutdown(fd, SHUT_RDWR);
+		close(fd);
 	}
-	return (NULL);
+
+	ScopedLock lock(_stateLock);
+	for (size_t i = 0; i < removed.size(); ++i)
+		_clientPool.release(removed[i]);
 }
 
 
-Client *Server::getClientByNickname(const std::string& nickname)
+Client *Server::getClientByNickname(const std::string& nickname) const
 {
-	for (size_t i = 0; i < _clients.size(); ++i)
-	{
-		if (_clients[i]->getNickname() == nickname) {
-			return _clients[i];
-		}
-	}
-	return (NULL);
+	NicknameIndex::const_iterator it = _nicknames.find(ircCasemap(nickname));
+	if (it == _nicknames.end())
+		return (NULL);
+	return (it->second);
+}
+
+
+// Moves the client to its new key in the nickname index and updates its nick
+void Server::renameClient(Client *client, const std::string &newNick)
+{
+	if (!client->getNickname().empty())
+		_nicknames.erase(ircCasemap(client->getNickname()));
+	_nicknames[ircCasemap(newNick)] = client;
+	client->setNickname(newNick);
 }
 
 
 Channel *Server::getChannel(const std::string &channelName)
 {
-	std::vector<Channel *>::iterator ite = _channels.end();
-	for (std::vector<Channel *>::iterator it = _channels.begin(); it != ite; ++it)
-	{
-		if ((*it)->getName() == channelName)
-			return (*it);
-	}
-	return (NULL);
+	ChannelIndex::iterator it = _channelIndex.find(ircCasemap(channelName));
+	if (it == _channelIndex.end())
+		return (NULL);
+	return (*it->second);
 }
 
 
 Channel *Server::createChannel(const std::string &channelName, const std::string &key, Client *client)
 {
-	Channel *newChannel = new Channel(channelName);
+	Channel *newChannel = _channelPool.acquire();
+	newChannel->init(channelName);
 	newChannel->setKey(key);
-	_channels.push_back(newChannel);
+	_channelIndex[ircCasemap(channelName)] = _channels.insert(_channels.end(), newChannel);
 	newChannel->addClient(client);
 	client->setOperator(true); // Automatically make the client an operator in the new channel
 	newChannel->addOperator(client);
 
-	std::cout << "Channel <" << channelName << "> created by " << client->getNickname() << std::endl;
-	std::cout << client->getNickname() << " is now an operator in channel <" << channelName << ">" << std::endl;
+	LOG_INFO(CHANNEL, "Channel <" << channelName << "> created by " << client->getNickname());
+	LOG_DEBUG(CHANNEL, client->getNickname() << " is now an operator in channel <" << channelName << ">");
 	return newChannel;
 }
 
 
 void Server::removeChannel(const std::string &channelName)
 {
-	std::vector<Channel *>::iterator ite = _channels.end();
-	for (std::vector<Channel *>::iterator it = _channels.begin(); it != ite; ++it)
-	{
-		if ((*it)->getName() == channelName)
-		{
-			delete *it;
-			it = _channels.erase(it);
-			std::cout << "Server deleted Channel <" << channelName << "> removed." << std::endl;
-			return;
-		}
-	}
+	ChannelIndex::iterator it = _channelIndex.find(ircCasemap(channelName));
+	if (it == _channelIndex.end())
+		return;
+
+	Channel *channel = *it->second;
+	_channels.erase(it->second);
+	_channelIndex.erase(it);
+	LOG_INFO(CHANNEL, "Server deleted Channel <" << channel->getName() << "> removed.");
+	_channelPool.release(channel);
 }
 
 
-void	Server::printChannels(Client *client, std::vector<std::string> args)
+void	Server::printChannels(Client *client, const IrcMessage &msg)
 {
 	(void)client;
-	(void)args;
-	std::vector<Channel*>::iterator it = _channels.begin();
+	(void)msg;
+	ChannelList::iterator it = _channels.begin();
 	while (it != _channels.end())
 	{
-		std::cout << "CHANNEL NAME: " << (*it)->getName() << std::endl;
-		std::vector<Client*> clients = (*it)->getClients();
-		std::vector<Client*>::iterator itt = clients.begin();
+		std::string members;
+		const Channel::MemberMap &clients = (*it)->getMembers();
+		Channel::MemberMap::const_iterator itt = clients.begin();
 		while (itt != clients.end())
 		{
-			std::cout << (*itt)->getNickname() << std::endl;
+			if (itt->second & Channel::MEMBER)
+				members += " " + itt->first->getNickname();
 			itt++;
 		}
+		LOG_INFO(SERVER, "CHANNEL NAME: " << (*it)->getName() << " MEMBERS:" << members);
 		it++;
 	}
 }
 
+void	Server::printStats(Client *client, const IrcMessage &msg)
+{
+	(void)client;
+	(void)msg;
+	LOG_INFO(SERVER, "CLIENTS: " << _clientCount << "  CHANNELS: " << _channels.size());
+	Worker::Stats total = Worker::Stats();
+	for (size_t i = 0; i < _workers.size(); ++i)
+	{
+		Worker::Stats stats = _workers[i]->getStats();	// snapshot, the worker may be running
+		total.commands += stats.commands;
+		total.writeCalls += stats.writeCalls;
+		total.flushes += stats.flushes;
+		total.iterations += stats.iterations;
+		total.busyUs += stats.busyUs;
+		total.maxIterationUs = std::max(total.maxIterationUs, stats.maxIterationUs);
+		for (size_t b = 0; b < Worker::ITERATION_BUCKETS; ++b)
+			total.iterationHistogram[b] += stats.iterationHistogram[b];
+	}
+	LOG_INFO(SERVER, "WORKERS: " << _workers.size());
+	LOG_INFO(SERVER, "COMMANDS: " << total.commands);
+	LOG_INFO(SERVER, "WRITE SYSCALLS: " << total.writeCalls << " (" << total.flushes << " flushes)");
+	if (total.commands)
+		LOG_INFO(SERVER, "SYSCALLS PER COMMAND: "
+			<< static_cast<double>(total.writeCalls) / total.commands);
+	const ObjectPool<Client>::Stats &clientPool = _clientPool.getStats();
+	LOG_INFO(SERVER, "CLIENT POOL: " << clientPool.inUse << "/" << clientPool.capacity << " in use, peak "
+		<< clientPool.peak << ", " << clientPool.reused << "/" << clientPool.acquired << " reused");
+	const ObjectPool<Channel>::Stats &channelPool = _channelPool.getStats();
+	LOG_INFO(SERVER, "CHANNEL POOL: " << channelPool.inUse << "/" << channelPool.capacity << " in use, peak "
+		<< channelPool.peak << ", " << channelPool.reused << "/" << channelPool.acquired << " reused");
+	if (total.iterations)
+	{
+		// Percentiles are upper bounds of power-of-two buckets
+		unsigned long p50 = 0, p99 = 0, seen = 0;
+		for (size_t b = 0; b < Worker::ITERATION_BUCKETS; ++b)
+		{
+			seen += total.iterationHistogram[b];
+			if (!p50 && seen * 2 >= total.iterations)
+				p50 = 2UL << b;
+			if (!p99 && seen * 100 >= total.iterations * 99)
+				p99 = 2UL << b;
+		}
+		LOG_INFO(SERVER, "LOOP ITERATIONS: " << total.iterations << " (budget " << _commandBudget
+			<< " commands per client), busy avg " << total.busyUs / total.iterations << " us, p50 < "
+			<< p50 << " us, p99 < " << p99 << " us, max " << total.maxIterationUs << " us");
+	}
+	LOG_INFO(SERVER, "CONNECTIONS REFUSED: " << _connectionThrottle.rejected()
+		<< " (" << _connectionThrottle.trackedAddresses() << " addresses tracked)");
+	LOG_INFO(SERVER, "LOG LINES DROPPED: " << Logger::dropped());
+}
+
 void	Server::logNewClient(Client* client)
 {
-	std::cout << "------------------------------" << std::endl;
-    	std::cout << "📢 New Client Registered!" << std::endl;
-    	std::cout << "Nickname: " << client->getNickname() << std::endl;
-    	std::cout << "Real Name: " << client->getRealname() << std::endl;
-    	std::cout << "IP Address: " << client->getIp() << std::endl;
-    	std::cout << "Socket: " << client->getSocket() << std::endl;
-    	std::cout << "------------------------------" << std::endl;
+	LOG_INFO(CLIENT, "📢 New Client Registered! Nickname: " << client->getNickname()
+		<< " Real Name: " << client->getRealname() << " IP Address: " << client->getIp()
+		<< " Socket: " << client->getSocket());
 }
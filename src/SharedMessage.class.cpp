@@ -0,0 +1,95 @@
+#include "../include/SharedMessage.class.hpp"
+#include <cstring>
+#include <new>
+
+SharedMessage::SharedMessage() : _block(NULL)
+{
+}
+
+
+SharedMessage::SharedMessage(const std::string &bytes) : _block(NULL)
+{
+	create(bytes.data(), bytes.size());
+}
+
+
+SharedMessage::SharedMessage(const char *bytes, size_t size) : _block(NULL)
+{
+	create(bytes, size);
+}
+
+
+SharedMessage::SharedMessage(const IrcLine &line) : _block(NULL)
+{
+	create(line.data(), line.size());
+}
+
+
+SharedMessage::SharedMessage(const SharedMessage &other) : _block(other._block)
+{
+	if (_block)
+		__sync_add_and_fetch(&_block->refs, 1);
+}
+
+
+SharedMessage &SharedMessage::operator=(const SharedMessage &other)
+{
+	if (_block != other._block)
+	{
+		if (other._block)
+			__sync_add_and_fetch(&other._block->refs, 1);
+		release();
+		_block = other._block;
+	}
+	return *this;
+}
+
+
+SharedMessage::~SharedMessage()
+{
+	release();
+}
+
+
+const char *SharedMessage::data() const
+{
+	return _block ? _block->bytes : "";
+}
+
+
+size_t SharedMessage::size() const
+{
+	return _block ? _block->size : 0;
+}
+
+
+bool SharedMessage::empty() const
+{
+	return size() == 0;
+}
+
+
+long SharedMessage::useCount() const
+{
+	return _block ? _block->refs : 0;
+}
+
+
+void SharedMessage::create(const char *bytes, size_t size)
+{
+	if (size == 0)
+		return;
+	void *raw = ::operator new(offsetof(Block, bytes) + size);
+	_block = static_cast<Block *>(raw);
+	_block->refs = 1;
+	_block->size = size;
+	memcpy(_block->bytes, bytes, size);
+}
+
+
+void SharedMessage::release()
+{
+	if (_block && __sync_sub_and_fetch(&_block->refs, 1) == 0)
+		::operator delete(_block);
+	_block = NULL;
+}
@@ -0,0 +1,137 @@
+#include "../include/TimerWheel.class.hpp"
+#include <time.h>
+
+TimerWheel::Timer::Timer() : prev(NULL), next(NULL), expires(0), owner(NULL)
+{
+}
+
+
+bool TimerWheel::Timer::pending() const
+{
+	return next != NULL;
+}
+
+
+TimerWheel::TimerWheel() : _current(nowMs() / TICK_MS), _count(0)
+{
+	for (unsigned int level = 0; level < LEVELS; ++level)
+	{
+		for (unsigned int i = 0; i < SLOTS; ++i)
+			_slots[level][i].prev = _slots[level][i].next = &_slots[level][i];
+	}
+}
+
+
+void TimerWheel::schedule(Timer &timer, unsigned long delayMs)
+{
+	if (timer.pending())
+		cancel(timer);
+	// Counted from the clock rather than from the last processed tick and
+	// rounded up, so that a timer never fires before its delay
+	timer.expires = (nowMs() + delayMs + TICK_MS - 1) / TICK_MS;
+	insert(timer);
+	++_count;
+}
+
+
+void TimerWheel::cancel(Timer &timer)
+{
+	if (!timer.pending())
+		return;
+	timer.prev->next = timer.next;
+	timer.next->prev = timer.prev;
+	timer.prev = timer.next = NULL;
+	--_count;
+}
+
+
+// The level is picked from the distance to the current tick
+void TimerWheel::insert(Timer &timer)
+{
+	if (timer.expires <= _current)
+		timer.expires = _current + 1;
+	unsigned long delta = timer.expires - _current;
+
+	unsigned int level = 0;
+	while (level < LEVELS - 1 && delta >= (1UL << (SLOT_BITS * (level + 1))))
+		++level;
+	// Delays beyond the span of the wheel (2^24 ticks) are capped to it
+	if (level == LEVELS - 1 && delta >= (1UL << (SLOT_BITS * LEVELS)))
+		timer.expires = _current + (1UL << (SLOT_BITS * LEVELS)) - 1;
+
+	Timer &head = _slots[level][(timer.expires >> (SLOT_BITS * level)) & (SLOTS - 1)];
+	timer.prev = head.prev;
+	timer.next = &head;
+	head.prev->next = &timer;
+	head.prev = &timer;
+}
+
+
+// Re-files the timers of one slot against the current tick, one level lower
+void TimerWheel::cascade(unsigned int level, unsigned int index)
+{
+	Timer &head = _slots[level][index];
+	Timer *timer = head.next;
+	head.prev = head.next = &head;
+	while (timer != &head)
+	{
+		Timer *next = timer->next;
+		insert(*timer);
+		timer = next;
+	}
+}
+
+
+void TimerWheel::advance(unsigned long nowMs, std::vector<Timer *> &expired)
+{
+	unsigned long target = nowMs / TICK_MS;
+	if (_count == 0)
+	{
+		// Nothing to fire: skip the idle period at once
+		if (target > _current)
+			_current = target;
+		return;
+	}
+
+	while (_current < target)
+	{
+		++_current;
+		for (unsigned int level = 1; level < LEVELS; ++level)
+		{
+			if (_current & ((1UL << (SLOT_BITS * level)) - 1))
+				break;
+			cascade(level, (_current >> (SLOT_BITS * level)) & (SLOTS - 1));
+		}
+
+		Timer &head = _slots[0][_current & (SLOTS - 1)];
+		while (head.next != &head)
+		{
+			Timer *timer = head.next;
+			cancel(*timer);
+			expired.push_back(timer);
+		}
+	}
+}
+
+
+int TimerWheel::timeoutMs(unsigned long nowMs) const
+{
+	if (_count == 0)
+		return -1;
+	unsigned long nextTick = (_current + 1) * TICK_MS;
+	return nextTick > nowMs ? static_cast<int>(nextTick - nowMs) : 0;
+}
+
+
+size_t TimerWheel::size() const
+{
+	return _count;
+}
+
+
+unsigned long TimerWheel::nowMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
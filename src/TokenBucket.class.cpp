@@ -0,0 +1,53 @@
+#include "../include/TokenBucket.class.hpp"
+
+TokenBucket::TokenBucket() : _milliTokens(0), _capacity(0), _rate(0), _lastRefillMs(0)
+{
+}
+
+
+void TokenBucket::reset(unsigned long burst, unsigned long rate, unsigned long nowMs)
+{
+	_capacity = burst * 1000;
+	_milliTokens = _capacity;
+	_rate = rate;
+	_lastRefillMs = nowMs;
+}
+
+
+bool TokenBucket::tryTake(unsigned long cost, unsigned long nowMs)
+{
+	if (_rate == 0)
+		return true;
+
+	if (nowMs > _lastRefillMs)
+	{
+		unsigned long elapsed = nowMs - _lastRefillMs;
+		unsigned long room = _capacity - _milliTokens;
+		// Compared by division first: elapsed * rate may not fit on long idle periods
+		if (elapsed >= room / _rate + 1)
+			_milliTokens = _capacity;
+		else
+			_milliTokens += elapsed * _rate;
+		_lastRefillMs = nowMs;
+	}
+
+	// A command dearer than the whole burst still goes through on a full bucket
+	unsigned long needed = cost * 1000;
+	if (needed > _capacity)
+		needed = _capacity;
+	if (_milliTokens < needed)
+		return false;
+	_milliTokens -= needed;
+	return true;
+}
+
+
+unsigned long TokenBucket::waitMs(unsigned long cost) const
+{
+	unsigned long needed = cost * 1000;
+	if (needed > _capacity)
+		needed = _capacity;
+	if (_rate == 0 || _milliTokens >= needed)
+		return 0;
+	return (needed - _milliTokens + _rate - 1) / _rate;
+}
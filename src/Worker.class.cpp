@@ -0,0 +1,326 @@
+#include "../include/Worker.class.hpp"
+#include "../include/Client.class.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Worker running on the calling thread, NULL outside of the reactor threads
+static __thread Worker *currentWorker = NULL;
+
+Worker::Worker(Server *server, size_t id)
+	: _server(server), _id(id), _listenFd(-1), _reserveFd(-1), _listenerPaused(false),
+	  _listenerPausedMs(0), _fdWarningMs(0), _fdExhaustions(0), _started(false),
+	  _inputReadyMs(0)
+{
+	_wakePipe[0] = -1;
+	_wakePipe[1] = -1;
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+
+Worker::~Worker()
+{
+	if (_listenFd >= 0)
+		close(_listenFd);
+	if (_reserveFd >= 0)
+		close(_reserveFd);
+	if (_wakePipe[0] >= 0)
+		close(_wakePipe[0]);
+	if (_wakePipe[1] >= 0)
+		close(_wakePipe[1]);
+}
+
+
+bool Worker::init(int listenFd)
+{
+	_listenFd = listenFd;
+	if (!_loop.init() || !_loop.add(_listenFd, EventLoop::READ))
+		return false;
+	_reserveFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (_reserveFd == -1)
+		return false;
+
+	if (pipe(_wakePipe) == -1)
+		return false;
+	for (int i = 0; i < 2; ++i)
+	{
+		if (fcntl(_wakePipe[i], F_SETFL, O_NONBLOCK) == -1
+			|| fcntl(_wakePipe[i], F_SETFD, FD_CLOEXEC) == -1)
+			return false;
+	}
+	return _loop.add(_wakePipe[0], EventLoop::READ);
+}
+
+
+Server *Worker::getServer() const
+{
+	return _server;
+}
+
+
+size_t Worker::getId() const
+{
+	return _id;
+}
+
+
+int Worker::getListenFd() const
+{
+	return _listenFd;
+}
+
+
+EventLoop &Worker::getLoop()
+{
+	return _loop;
+}
+
+
+TimerWheel &Worker::getTimers()
+{
+	return _timers;
+}
+
+
+bool Worker::isWakeFd(int fd) const
+{
+	return fd == _wakePipe[0];
+}
+
+
+Client *Worker::getClient(int fd) const
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= _clients.size())
+		return NULL;
+	return _clients[fd];
+}
+
+
+void Worker::addClient(Client *client)
+{
+	int fd = client->getSocket();
+	if (static_cast<size_t>(fd) >= _clients.size())	// grow the fd-indexed slot table
+		_clients.resize(fd + 1, NULL);
+	_clients[fd] = client;
+}
+
+
+void Worker::removeClient(int fd)
+{
+	if (fd >= 0 && static_cast<size_t>(fd) < _clients.size())
+		_clients[fd] = NULL;
+}
+
+
+const std::vector<Client *> &Worker::getClients() const
+{
+	return _clients;
+}
+
+
+void Worker::scheduleFlush(int fd)
+{
+	bool mustWake;
+	{
+		ScopedLock lock(_flushLock);
+		// The owner flushes at the end of its iteration; others must wake it up
+		mustWake = _flushQueue.empty() && currentWorker != this;
+		_flushQueue.push_back(fd);
+	}
+	if (mustWake)
+		wake();
+}
+
+
+void Worker::takeFlushQueue(std::vector<int> &queue)
+{
+	queue.clear();
+	ScopedLock lock(_flushLock);
+	queue.swap(_flushQueue);
+}
+
+
+void Worker::wake()
+{
+	char byte = 1;
+	// A full pipe already guarantees a wakeup
+	while (write(_wakePipe[1], &byte, 1) == -1 && errno == EINTR)
+		;
+}
+
+
+void Worker::drainWakeups()
+{
+	char buffer[64];
+	while (read(_wakePipe[0], buffer, sizeof(buffer)) > 0)
+		;
+}
+
+
+void Worker::queueInput(int fd, unsigned long readyAtMs)
+{
+	if (_inputQueue.empty() || readyAtMs < _inputReadyMs)
+		_inputReadyMs = readyAtMs;
+	_inputQueue.push_back(fd);
+}
+
+
+// FIFO: clients still left with lines are queued again behind the others
+void Worker::takeInputQueue(std::vector<int> &fds)
+{
+	fds.clear();
+	fds.swap(_inputQueue);
+}
+
+
+int Worker::inputTimeoutMs(unsigned long nowMs) const
+{
+	if (_inputQueue.empty())
+		return -1;
+	return _inputReadyMs > nowMs ? static_cast<int>(_inputReadyMs - nowMs) : 0;
+}
+
+
+bool Worker::refusePendingConnection()
+{
+	if (_reserveFd < 0)
+	{
+		errno = EMFILE;
+		return false;
+	}
+	close(_reserveFd);
+	int fd = accept4(_listenFd, NULL, NULL, SOCK_CLOEXEC);
+	int error = errno;
+	if (fd >= 0)
+		close(fd);
+	_reserveFd = open("/dev/null", O_RDONLY | O_CLOEXEC);	// -1 if another thread took it
+	errno = error;
+	return fd >= 0;
+}
+
+
+void Worker::pauseListener(unsigned long nowMs)
+{
+	if (_listenerPaused)
+		return;
+	_loop.remove(_listenFd);
+	_listenerPaused = true;
+	_listenerPausedMs = nowMs;
+}
+
+
+bool Worker::isListenerPaused() const
+{
+	return _listenerPaused;
+}
+
+
+void Worker::retryListener(unsigned long nowMs, bool descriptorsFreed)
+{
+	if (!_listenerPaused || (!descriptorsFreed && nowMs - _listenerPausedMs < LISTENER_RETRY_MS))
+		return;
+	if (_reserveFd < 0)
+		_reserveFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (_loop.add(_listenFd, EventLoop::READ))
+		_listenerPaused = false;
+	else
+		_listenerPausedMs = nowMs;
+}
+
+
+bool Worker::fdWarningDue(unsigned long nowMs, unsigned long &count)
+{
+	++_fdExhaustions;
+	if (_fdWarningMs != 0 && nowMs - _fdWarningMs < FD_WARNING_INTERVAL_MS)
+		return false;
+	count = _fdExhaustions;
+	_fdExhaustions = 0;
+	_fdWarningMs = nowMs;
+	return true;
+}
+
+
+void Worker::bindToCurrentThread()
+{
+	currentWorker = this;
+}
+
+
+bool Worker::start(void *(*routine)(void *))
+{
+	int error = pthread_create(&_thread, NULL, routine, this);
+	_started = (error == 0);
+	if (error)
+		errno = error;
+	return _started;
+}
+
+
+void Worker::join()
+{
+	if (_started)
+		pthread_join(_thread, NULL);
+	_started = false;
+}
+
+
+void Worker::scheduleRemoval(Client *client)
+{
+	_clientsToRemove.push_back(client);
+}
+
+
+void Worker::takeClientsToRemove(std::vector<Client *> &clients)
+{
+	clients.clear();
+	clients.swap(_clientsToRemove);
+}
+
+
+Worker::Stats Worker::getStats() const
+{
+	ScopedLock lock(_statsLock);
+	return _stats;
+}
+
+
+void Worker::countCommand()
+{
+	ScopedLock lock(_statsLock);
+	_stats.commands++;
+}
+
+
+void Worker::countWriteCalls(unsigned long writeCalls, bool flush)
+{
+	ScopedLock lock(_statsLock);
+	_stats.writeCalls += writeCalls;
+	if (flush)
+		_stats.flushes++;
+}
+
+
+void Worker::recordIteration(unsigned long busyUs)
+{
+	size_t bucket = 0;
+	while (bucket < ITERATION_BUCKETS - 1 && (busyUs >> (bucket + 1)) != 0)
+		++bucket;
+
+	ScopedLock lock(_statsLock);
+	_stats.iterations++;
+	_stats.busyUs += busyUs;
+	if (busyUs > _stats.maxIterationUs)
+		_stats.maxIterationUs = busyUs;
+	_stats.iterationHistogram[bucket]++;
+}
+
+
+unsigned long Worker::monotonicUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
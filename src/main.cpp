@@ -13,14 +13,30 @@ int main(int ac, char **av) {
 		long port = parse_port(port_str);
 		std::string password = parse_password(av[2]);
 
-		Server server(port, password);
+		size_t workers = parse_worker_count(std::getenv("IRCSERV_WORKERS"));
+		unsigned long floodBurst = parse_env_number("IRCSERV_FLOOD_BURST", Server::DEFAULT_FLOOD_BURST, 1, 10000);
+		unsigned long floodRate = parse_env_number("IRCSERV_FLOOD_RATE", Server::DEFAULT_FLOOD_RATE, 0, 10000);
+		unsigned long connectionBurst = parse_env_number("IRCSERV_CONN_BURST", Server::DEFAULT_CONNECTION_BURST, 1, 100000);
+		unsigned long connectionRate = parse_env_number("IRCSERV_CONN_RATE", Server::DEFAULT_CONNECTION_RATE, 0, 100000);
+		unsigned long commandBudget = parse_env_number("IRCSERV_COMMAND_BUDGET", Server::DEFAULT_COMMAND_BUDGET, 1, 100000);
+		if (!Logger::configure(std::getenv("IRCSERV_LOG_LEVEL"), std::getenv("IRCSERV_LOG_CATEGORIES")))
+			throw std::invalid_argument("Invalid IRCSERV_LOG_LEVEL or IRCSERV_LOG_CATEGORIES");
+
+		Logger::start();
+
+		Server server(port, password, workers);
+		server.setFloodControl(floodBurst, floodRate);
+		server.setCommandBudget(commandBudget);
+		server.setConnectionThrottle(connectionBurst, connectionRate);
 
 		signal(SIGINT, Server::signalHandler);
 		signal(SIGQUIT, Server::signalHandler);
+		signal(SIGPIPE, SIG_IGN); // a peer closing mid-write must not kill the server
 		server.init();
 		server.run();
 	
 	} catch (const std::exception& e) {
 				std::cerr << e.what() << std::endl;
 	}
+	Logger::stop(); // write what the background thread has not drained yet
 }
@@ -25,4 +25,51 @@ std::string parse_password(const std::string &password) {
 		throw std::runtime_error("Password too long, must be less than 64 characters");
 	}
 	return password;
-}
\ No newline at end of file
+}
+
+size_t parse_worker_count(const char *value) {
+	if (value == NULL || *value == '\0') {
+		return 1;
+	}
+	std::string count(value);
+	if (count.find_first_not_of("0123456789") != std::string::npos || count.length() > 3) {
+		throw std::invalid_argument("IRCSERV_WORKERS must be a number between 1 and 256");
+	}
+	long workers = std::strtol(count.c_str(), NULL, 10);
+	if (workers < 1 || workers > 256) {
+		throw std::out_of_range("IRCSERV_WORKERS must be a number between 1 and 256");
+	}
+	return workers;
+}
+
+// Optional numeric setting from the environment, fallback when it is unset
+unsigned long parse_env_number(const char *name, unsigned long fallback, unsigned long min, unsigned long max) {
+	const char *value = std::getenv(name);
+	if (value == NULL || *value == '\0') {
+		return fallback;
+	}
+	std::string number(value);
+	std::ostringstream range;
+	range << name << " must be a number between " << min << " and " << max;
+	if (number.find_first_not_of("0123456789") != std::string::npos || number.length() > 9) {
+		throw std::invalid_argument(range.str());
+	}
+	unsigned long result = std::strtoul(number.c_str(), NULL, 10);
+	if (result < min || result > max) {
+		throw std::out_of_range(range.str());
+	}
+	return result;
+}
+
+char ircToLower(char c) {
+	if (c >= 'A' && c <= '^')	// 'A'-'Z' then '[', '\\', ']', '^'
+		return c + ('a' - 'A');
+	return c;
+}
+
+std::string ircCasemap(const std::string &name) {
+	std::string folded(name);
+	for (size_t i = 0; i < folded.size(); ++i)
+		folded[i] = ircToLower(folded[i]);
+	return folded;
+}